@@ -3,8 +3,17 @@ QT      += widgets
 CONFIG  += c++17
 
 SOURCES += \
+    engine.cpp \
     main.cpp \
+    portfolio.cpp \
+    probe.cpp \
+    snapshot.cpp \
     sudoku.cpp
 
 HEADERS += \
-    sudoku.h
+    engine.h \
+    portfolio.h \
+    probe.h \
+    snapshot.h \
+    sudoku.h \
+    units.h
@@ -0,0 +1,22 @@
+QT       = core network
+
+CONFIG  += c++17 console
+CONFIG  -= app_bundle
+
+TARGET   = sdkd
+
+SOURCES += \
+    engine.cpp \
+    lanes.cpp \
+    portfolio.cpp \
+    sat.cpp \
+    server.cpp \
+    server_main.cpp
+
+HEADERS += \
+    engine.h \
+    lanes.h \
+    portfolio.h \
+    sat.h \
+    server.h \
+    units.h
@@ -0,0 +1,672 @@
+#include "engine.h"
+#include "units.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+namespace Engine
+{
+
+namespace
+{
+
+// Данный класс нужен только для того, чтобы создавать и решать судоку
+class Cell
+{
+private:
+    bool _free_digits[9];
+    int _digit; // 0 - нет числа
+public:
+    Cell(const int digit = 0)
+    {
+        _digit = digit;
+        for (int i = 0; i < 9; i += 1) _free_digits[i] = true; // изначально все свободны
+    }
+
+    void Reset()
+    {
+        for (int i = 0; i < 9; i += 1) _free_digits[i] = true; // изначально все свободны
+        _digit = 0;
+    }
+
+    int GetDigit()
+    {
+        return _digit;
+    }
+
+    void RemoveFD(int digit)
+    {
+        if (digit == 0) return;
+        _free_digits[digit - 1] = false;
+    }
+
+    bool GenerateDigit(std::mt19937& rng)
+    {
+        int fd_count = 0;
+        for (int i = 0; i < 9; i += 1) fd_count += _free_digits[i];
+
+        if (fd_count == 0) return false;
+
+        int tmp = rng() % fd_count;
+        int true_num = 0;
+        while (true)
+        {
+            if (_free_digits[true_num])
+            {
+                if (tmp == 0) break;
+                tmp -= 1;
+            }
+            true_num += 1;
+        }
+
+        _digit = true_num + 1;
+        _free_digits[true_num] = false;
+        return true;
+    }
+
+    void SetDigit(int digit)
+    {
+        _digit = digit;
+    }
+};
+
+// Битовое представление доски для быстрых проверок (оценка и валидация)
+struct Candidates
+{
+    int digits[81] = {};
+    uint16_t rows[9] = {};
+    uint16_t columns[9] = {};
+    uint16_t squares[9] = {};
+
+    uint16_t Free(int index) const
+    {
+        int row = index / 9;
+        int column = index % 9;
+        return ~(rows[row] | columns[column] | squares[row / 3 * 3 + column / 3]) & 0x1FF;
+    }
+
+    bool Place(int index, int digit)
+    {
+        uint16_t bit = 1 << (digit - 1);
+        if (not (Free(index) & bit)) return false;
+        int row = index / 9;
+        int column = index % 9;
+        digits[index] = digit;
+        rows[row] |= bit;
+        columns[column] |= bit;
+        squares[row / 3 * 3 + column / 3] |= bit;
+        return true;
+    }
+};
+
+int BitToDigit(uint16_t bit)
+{
+    int digit = 1;
+    while (not (bit & 1))
+    {
+        bit >>= 1;
+        digit += 1;
+    }
+    return digit;
+}
+
+bool Load(const Board& board, Candidates& candidates)
+{
+    if (HasConflict(board)) return false;
+    for (int row = 0; row < 9; row += 1)
+    {
+        for (int column = 0; column < 9; column += 1)
+        {
+            if (board.locked[row][column]) candidates.Place(row * 9 + column, board.digits[row][column]);
+        }
+    }
+    return true;
+}
+
+// Расставляет одиночки, пока это возможно. false - противоречие.
+bool Propagate(Candidates& candidates, bool hidden_singles, bool* used_hidden = nullptr)
+{
+    bool progress = true;
+    while (progress)
+    {
+        progress = false;
+        for (int index = 0; index < 81; index += 1)
+        {
+            if (candidates.digits[index] != 0) continue;
+            uint16_t free = candidates.Free(index);
+            if (free == 0) return false;
+            if ((free & (free - 1)) == 0)
+            {
+                candidates.Place(index, BitToDigit(free));
+                progress = true;
+            }
+        }
+        if (progress or not hidden_singles) continue;
+
+        for (int unit = 0; unit < 27; unit += 1)
+        {
+            for (int digit = 1; digit <= 9; digit += 1)
+            {
+                uint16_t bit = 1 << (digit - 1);
+                int count = 0;
+                int place = -1;
+                bool solved = false;
+                for (int k = 0; k < 9; k += 1)
+                {
+                    int index = units.cells[unit][k];
+                    if (candidates.digits[index] == digit)
+                    {
+                        solved = true;
+                        break;
+                    }
+                    if ((candidates.digits[index] == 0) and (candidates.Free(index) & bit))
+                    {
+                        count += 1;
+                        place = index;
+                    }
+                }
+                if (solved) continue;
+                if (count == 0) return false;
+                if (count == 1)
+                {
+                    candidates.Place(place, digit);
+                    if (used_hidden) *used_hidden = true;
+                    progress = true;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool IsSolved(const Candidates& candidates)
+{
+    for (int index = 0; index < 81; index += 1)
+    {
+        if (candidates.digits[index] == 0) return false;
+    }
+    return true;
+}
+
+// Считает решения до limit; первое найденное кладёт в first
+void CountSolutions(Candidates candidates, int limit, int& found,
+                    Candidates* first = nullptr, const std::atomic<bool>* stop = nullptr)
+{
+    if (stop and stop->load(std::memory_order_relaxed)) return;
+    if (not Propagate(candidates, true)) return;
+
+    int best = -1;
+    int best_count = 10;
+    for (int index = 0; index < 81; index += 1)
+    {
+        if (candidates.digits[index] != 0) continue;
+        int count = __builtin_popcount(candidates.Free(index));
+        if (count < best_count)
+        {
+            best = index;
+            best_count = count;
+        }
+    }
+    if (best == -1)
+    {
+        if (first and (found == 0)) *first = candidates;
+        found += 1;
+        return;
+    }
+
+    uint16_t free = candidates.Free(best);
+    for (int digit = 1; digit <= 9; digit += 1)
+    {
+        if (not (free & (1 << (digit - 1)))) continue;
+        Candidates next = candidates;
+        next.Place(best, digit);
+        CountSolutions(next, limit, found, first, stop);
+        if (found >= limit) return;
+    }
+}
+
+}
+
+Units::Units()
+{
+    for (int i = 0; i < 9; i += 1)
+    {
+        for (int j = 0; j < 9; j += 1)
+        {
+            cells[i][j] = i * 9 + j;                                  // строки
+            cells[9 + i][j] = j * 9 + i;                              // столбцы
+            cells[18 + i][j] = (i / 3 * 3 + j / 3) * 9 + i % 3 * 3 + j % 3; // квадраты
+        }
+    }
+}
+
+const Units units;
+
+bool HasConflict(const Board& board)
+{
+    uint16_t rows[9] = {};
+    uint16_t columns[9] = {};
+    uint16_t squares[9] = {};
+    for (int row = 0; row < 9; row += 1)
+    {
+        for (int column = 0; column < 9; column += 1)
+        {
+            if (not board.locked[row][column]) continue;
+            int digit = board.digits[row][column];
+            if ((digit < 1) or (digit > 9)) return true;
+            uint16_t bit = 1 << (digit - 1);
+            int square = row / 3 * 3 + column / 3;
+            if ((rows[row] | columns[column] | squares[square]) & bit) return true;
+            rows[row] |= bit;
+            columns[column] |= bit;
+            squares[square] |= bit;
+        }
+    }
+    return false;
+}
+
+std::mt19937& ThreadRng()
+{
+    thread_local std::mt19937 rng{std::random_device{}()};
+    return rng;
+}
+
+void Generate(Board& board, int open_slots_count, std::mt19937& rng)
+{
+    Cell sdk[9][9];
+
+    for (int row = 0; row < 9; )
+    {
+        for (int column = 0; column < 9; )
+        {
+            for (int tmp_column = 0; tmp_column < column; tmp_column += 1)
+            {
+                sdk[row][column].RemoveFD(sdk[row][tmp_column].GetDigit());
+            }
+            for (int tmp_row = 0; tmp_row < row; tmp_row += 1)
+            {
+                sdk[row][column].RemoveFD(sdk[tmp_row][column].GetDigit());
+            }
+
+            {
+                int tmp_row = row / 3 * 3;
+                int tmp_column = column / 3 * 3;
+
+                while (not ((tmp_row == row) && (tmp_column == column)))
+                {
+                    sdk[row][column].RemoveFD(sdk[tmp_row][tmp_column].GetDigit());
+                    tmp_column += 1;
+                    if (tmp_column >= column / 3 * 3 + 3)
+                    {
+                        tmp_row += 1;
+                        tmp_column = column / 3 * 3;
+                    }
+                }
+            }
+
+
+            if (not sdk[row][column].GenerateDigit(rng))
+            {
+                if ((row == 0) and (column == 0)) exit(-1);
+                sdk[row][column].Reset();
+                if (column == 0)
+                {
+                    row -= 1;
+                    column = 8;
+                }
+                else column -= 1;
+
+                continue;
+            }
+            column += 1;
+        }
+        row += 1;
+    }
+
+    bool opened[9 * 9];
+    for (int i = 0; i < 9 * 9; i += 1)
+    {
+        opened[i] = false;
+    }
+
+    for (int i = 0; i < open_slots_count; i += 1)
+    {
+        int tmp = rng() % (9 * 9 - i);
+        int true_num = 0;
+        while (true)
+        {
+            if (not opened[true_num])
+            {
+                if (tmp == 0)
+                {
+                    break;
+                }
+                tmp -= 1;
+            }
+            true_num += 1;
+        }
+        opened[true_num] = true;
+    }
+
+    for (int row = 0; row < 9; row += 1)
+    {
+        for (int column = 0; column < 9; column += 1)
+        {
+            board.locked[row][column] = opened[column + (row * 9)];
+            board.digits[row][column] = board.locked[row][column] ? sdk[row][column].GetDigit() : 0;
+        }
+    }
+}
+
+bool Solve(Board& board, std::mt19937& rng)
+{
+    bool stopped;
+    return Solve(board, rng, -1, nullptr, stopped);
+}
+
+bool Solve(Board& board, std::mt19937& rng, long long step_limit, const std::atomic<bool>* stop, bool& stopped)
+{
+    stopped = false;
+    long long steps = 0;
+
+    bool columns [9][9];
+    bool rows [9][9];;
+    bool squares [9][9];
+    for (int i = 0; i < 9; i+=1)
+    {
+        for (int j = 0; j < 9; j += 1)
+        {
+            columns[i][j] = true;
+            rows[i][j] = true;
+            squares[i][j] = true;
+        }
+    }
+
+    for (int column = 0; column < 9; column += 1)
+    {
+        for (int row = 0; row < 9; row += 1)
+        {
+            if (not board.locked[row][column])
+            {
+                continue;
+            }
+
+            int digit = board.digits[row][column];
+            if ((digit < 1) or (digit > 9))
+            {
+                return false;
+            }
+
+            if ((columns[column][digit - 1]) and (rows[row][digit - 1])
+                    and (squares[row / 3 + column / 3 * 3][digit - 1]))
+            {
+                columns[column][digit - 1] = false;
+                rows[row][digit - 1] = false;
+                squares[row / 3 + column / 3 * 3][digit - 1] = false;
+            }
+            else
+            {
+                return false;
+            }
+        }
+    }
+
+    Cell sdk[9][9];
+
+    for (int row = 0; row < 9; )
+    {
+        for (int column = 0; column < 9; )
+        {
+            if (board.locked[row][column])
+            {
+                sdk[row][column].SetDigit(board.digits[row][column]);
+                column += 1;
+                continue;
+            }
+            for (int tmp_column = 0; tmp_column < column; tmp_column += 1)
+            {
+                sdk[row][column].RemoveFD(sdk[row][tmp_column].GetDigit());
+            }
+            for (int tmp_row = 0; tmp_row < row; tmp_row += 1)
+            {
+                sdk[row][column].RemoveFD(sdk[tmp_row][column].GetDigit());
+            }
+            for (int tmp_column = column+1; tmp_column < 9; tmp_column += 1)
+            {
+                if (board.locked[row][tmp_column])
+                {
+                    sdk[row][column].RemoveFD(board.digits[row][tmp_column]);
+                }
+            }
+            for (int tmp_row = row+1; tmp_row < 9; tmp_row += 1)
+            {
+                if (board.locked[tmp_row][column])
+                {
+                    sdk[row][column].RemoveFD(board.digits[tmp_row][column]);
+                }
+            }
+
+            {
+                int tmp_row = row / 3 * 3;
+                int tmp_column = column / 3 * 3;
+                while (not ((tmp_row == row) and (tmp_column == column)))
+                {
+                    sdk[row][column].RemoveFD(sdk[tmp_row][tmp_column].GetDigit());
+                    tmp_column += 1;
+                    if (tmp_column >= column / 3 * 3 + 3)
+                    {
+                        tmp_row += 1;
+                        tmp_column = column / 3 * 3;
+                    }
+                }
+            }
+
+            {
+                int tmp_row = row / 3 * 3 + 2;
+                int tmp_column = column / 3 * 3 + 2;
+                while (not ((tmp_row == row) and (tmp_column == column)))
+                {
+                    if (board.locked[tmp_row][tmp_column])
+                    {
+                        sdk[row][column].RemoveFD(board.digits[tmp_row][tmp_column]);
+                    }
+                    tmp_column -= 1;
+                    if (tmp_column < column / 3 * 3)
+                    {
+                        tmp_row -= 1;
+                        tmp_column = column / 3 * 3 + 2;
+                    }
+                }
+            }
+
+            if (not sdk[row][column].GenerateDigit(rng))
+            {
+                steps += 1;
+                if (((step_limit >= 0) and (steps > step_limit)) or (stop and stop->load(std::memory_order_relaxed)))
+                {
+                    stopped = true;
+                    return false;
+                }
+
+                sdk[row][column].Reset();
+
+                if (column == 0)
+                {
+                    row -= 1;
+                    column = 9 -1;
+                }
+                else column -= 1;
+
+                if (row<0)
+                {
+                    return false;
+                }
+
+                while (board.locked[row][column])
+                {
+
+                    if (column == 0)
+                    {
+                        row -= 1;
+                        column = 9 - 1;
+                    }
+                    else column -= 1;
+
+                    if (row<0)
+                    {
+                        return false;
+                    }
+                }
+
+                continue;
+            }
+            column += 1;
+        }
+        row += 1;
+    }
+
+    for (int row = 0; row < 9; row += 1)
+    {
+        for (int column = 0; column < 9; column += 1)
+        {
+            board.digits[row][column] = sdk[row][column].GetDigit();
+        }
+    }
+    return true;
+}
+
+bool SolveBacktracking(Board& board, const std::atomic<bool>* stop)
+{
+    Candidates candidates;
+    if (not Load(board, candidates)) return false;
+
+    Candidates solution;
+    int found = 0;
+    CountSolutions(candidates, 1, found, &solution, stop);
+    if (found == 0) return false;
+
+    for (int index = 0; index < 81; index += 1)
+    {
+        board.digits[index / 9][index % 9] = solution.digits[index];
+    }
+    return true;
+}
+
+Grade Rate(const Board& board)
+{
+    Candidates candidates;
+    if (not Load(board, candidates)) return Grade::Invalid;
+
+    if (not Propagate(candidates, false)) return Grade::Invalid;
+    if (IsSolved(candidates)) return Grade::Easy;
+
+    if (not Propagate(candidates, true)) return Grade::Invalid;
+    if (IsSolved(candidates)) return Grade::Medium;
+
+    int found = 0;
+    CountSolutions(candidates, 1, found);
+    return found ? Grade::Hard : Grade::Invalid;
+}
+
+Validity Validate(const Board& board)
+{
+    Candidates candidates;
+    if (not Load(board, candidates)) return Validity::Conflict;
+
+    int found = 0;
+    CountSolutions(candidates, 2, found);
+    if (found == 0) return Validity::NoSolution;
+    return found == 1 ? Validity::Unique : Validity::Multiple;
+}
+
+bool FromString(const std::string& text, Board& board)
+{
+    if (text.size() != 81) return false;
+    for (int index = 0; index < 81; index += 1)
+    {
+        char c = text[index];
+        int row = index / 9;
+        int column = index % 9;
+        if ((c >= '1') and (c <= '9'))
+        {
+            board.digits[row][column] = c - '0';
+            board.locked[row][column] = true;
+        }
+        else if ((c == '0') or (c == '.'))
+        {
+            board.digits[row][column] = 0;
+            board.locked[row][column] = false;
+        }
+        else return false;
+    }
+    return true;
+}
+
+std::string ToString(const Board& board)
+{
+    std::string text(81, '0');
+    for (int index = 0; index < 81; index += 1)
+    {
+        text[index] = char('0' + board.digits[index / 9][index % 9]);
+    }
+    return text;
+}
+
+bool FromString(const std::string& text, int box_size, std::vector<int>& cells)
+{
+    if ((box_size < 2) or (box_size > 5)) return false;
+    const int n = box_size * box_size;
+    if (int(text.size()) != n * n) return false;
+
+    cells.assign(n * n, 0);
+    for (int index = 0; index < n * n; index += 1)
+    {
+        char c = text[index];
+        int digit = -1;
+        if ((c == '0') or (c == '.')) digit = 0;
+        else if ((c >= '1') and (c <= '9')) digit = c - '0';
+        else if ((c >= 'A') and (c <= 'Z')) digit = c - 'A' + 10;
+        else if ((c >= 'a') and (c <= 'z')) digit = c - 'a' + 10;
+        if ((digit < 0) or (digit > n)) return false;
+        cells[index] = digit;
+    }
+    return true;
+}
+
+std::string ToString(int box_size, const std::vector<int>& cells)
+{
+    const int n = box_size * box_size;
+    std::string text(n * n, '0');
+    for (int index = 0; index < n * n; index += 1)
+    {
+        int digit = cells[index];
+        text[index] = digit < 10 ? char('0' + digit) : char('A' + digit - 10);
+    }
+    return text;
+}
+
+const char* GradeName(Grade grade)
+{
+    switch (grade)
+    {
+    case Grade::Easy: return "easy";
+    case Grade::Medium: return "medium";
+    case Grade::Hard: return "hard";
+    case Grade::Invalid: break;
+    }
+    return "invalid";
+}
+
+const char* ValidityName(Validity validity)
+{
+    switch (validity)
+    {
+    case Validity::Conflict: return "conflict";
+    case Validity::NoSolution: return "none";
+    case Validity::Unique: return "unique";
+    case Validity::Multiple: break;
+    }
+    return "multiple";
+}
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <random>
+#include <string>
+#include <vector>
+
+// Логика генерации и решения судоку без зависимостей от Qt Widgets.
+// Используется и окном игры, и фоновым сервером (sdkd).
+namespace Engine
+{
+
+struct Board
+{
+    int digits[9][9] = {}; // 0 - нет числа
+    bool locked[9][9] = {}; // true - клетка задана условием
+};
+
+enum class Grade
+{
+    Easy,   // хватает "голых" одиночек
+    Medium, // нужны "скрытые" одиночки
+    Hard,   // нужен перебор
+    Invalid // нет решения или противоречие в условии
+};
+
+enum class Validity
+{
+    Conflict,   // заданные клетки противоречат друг другу
+    NoSolution,
+    Unique,
+    Multiple
+};
+
+// Генератор случайных чисел, свой для каждого потока
+std::mt19937& ThreadRng();
+
+// Заполняет доску и оставляет open_slots_count заблокированных подсказок.
+// open_slots_count == 0 - пустая доска (режим песочницы).
+void Generate(Board& board, int open_slots_count, std::mt19937& rng);
+
+// Решает доску, учитывая только заблокированные клетки.
+// При успехе заполняет все digits и возвращает true.
+bool Solve(Board& board, std::mt19937& rng);
+
+// То же с ограничением числа откатов (step_limit < 0 - без ограничения) и
+// внешней отменой. stopped - решение не найдено из-за ограничения или отмены,
+// а не потому что его нет.
+bool Solve(Board& board, std::mt19937& rng, long long step_limit, const std::atomic<bool>* stop, bool& stopped);
+
+// Перебор с распространением одиночек и выбором клетки с наименьшим числом
+// вариантов. При отмене через stop возвращает false.
+bool SolveBacktracking(Board& board, const std::atomic<bool>* stop = nullptr);
+
+Grade Rate(const Board& board);
+Validity Validate(const Board& board);
+
+// Строка из 81 символа: '1'-'9' - подсказка, '0' или '.' - пустая клетка
+bool FromString(const std::string& text, Board& board);
+std::string ToString(const Board& board);
+
+// Доска box_size^2 x box_size^2 (до 25x25): цифры больше 9 записываются
+// буквами 'A' - 10, 'B' - 11 и т.д., '0' или '.' - пустая клетка
+bool FromString(const std::string& text, int box_size, std::vector<int>& cells);
+std::string ToString(int box_size, const std::vector<int>& cells);
+
+const char* GradeName(Grade grade);
+const char* ValidityName(Validity validity);
+
+}
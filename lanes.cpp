@@ -0,0 +1,353 @@
+#include "lanes.h"
+#include "units.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Engine
+{
+
+namespace
+{
+
+constexpr uint16_t all_digits = 0x1FF;
+
+// Все дорожки одной клетки - один вектор (расширение GCC/Clang: операции
+// применяются поэлементно, сравнение даёт 0 или 0xFFFF в каждой дорожке)
+typedef uint16_t LaneVec __attribute__((vector_size(2 * lane_count)));
+
+// Состояние дорожек: кандидаты каждой клетки на всех досках и маска
+// "мёртвых" дорожек (пустые или с противоречием), 0xFFFF - мёртвая
+struct LaneBoard
+{
+    LaneVec cand[81];
+    LaneVec dead;
+};
+
+LaneVec Singles(LaneVec v)
+{
+    return v & LaneVec((v & (v - 1)) == 0);
+}
+
+bool AnyAlive(LaneVec changed, LaneVec dead)
+{
+    LaneVec alive = changed & ~dead;
+    uint16_t any = 0;
+    for (int lane = 0; lane < lane_count; lane += 1) any |= alive[lane];
+    return any;
+}
+
+void Load(const Board* boards, int count, LaneBoard& lanes)
+{
+    for (int lane = 0; lane < lane_count; lane += 1)
+    {
+        bool used = (lane < count) and not HasConflict(boards[lane]);
+        lanes.dead[lane] = used ? 0 : 0xFFFF;
+        for (int index = 0; index < 81; index += 1)
+        {
+            int row = index / 9;
+            int column = index % 9;
+            lanes.cand[index][lane] = (used and boards[lane].locked[row][column])
+                    ? uint16_t(1 << (boards[lane].digits[row][column] - 1)) : all_digits;
+        }
+    }
+}
+
+// Убирает из кандидатов клетки цифры соседей, у которых остался один кандидат.
+// Одиночки собираются по строкам, столбцам и квадратам, а не по 20 соседям клетки.
+bool NakedSingles(LaneBoard& lanes)
+{
+    LaneVec singles[27];
+    for (int unit = 0; unit < 27; unit += 1)
+    {
+        LaneVec seen = {};
+        for (int k = 0; k < 9; k += 1)
+        {
+            LaneVec single = Singles(lanes.cand[units.cells[unit][k]]);
+            // одна и та же цифра дважды в строке, столбце или квадрате
+            lanes.dead |= LaneVec((seen & single) != 0);
+            seen |= single;
+        }
+        singles[unit] = seen;
+    }
+
+    LaneVec changed = {};
+    for (int index = 0; index < 81; index += 1)
+    {
+        LaneVec v = lanes.cand[index];
+        LaneVec keep = LaneVec((v & (v - 1)) == 0);
+        LaneVec taken = singles[index / 9] | singles[9 + index % 9] | singles[18 + index / 27 * 3 + index % 9 / 3];
+        LaneVec next = v & (~taken | keep);
+        lanes.dead |= LaneVec(next == 0);
+        changed |= next ^ v;
+        lanes.cand[index] = next;
+    }
+    return AnyAlive(changed, lanes.dead);
+}
+
+// Цифра, которая в строке, столбце или квадрате возможна только в одной клетке
+bool HiddenSingles(LaneBoard& lanes)
+{
+    LaneVec changed = {};
+    for (int unit = 0; unit < 27; unit += 1)
+    {
+        LaneVec once = {};
+        LaneVec twice = {};
+        for (int k = 0; k < 9; k += 1)
+        {
+            LaneVec w = lanes.cand[units.cells[unit][k]];
+            twice |= once & w;
+            once |= w;
+        }
+        lanes.dead |= LaneVec(once != all_digits);
+        once &= ~twice;
+
+        for (int k = 0; k < 9; k += 1)
+        {
+            LaneVec v = lanes.cand[units.cells[unit][k]];
+            LaneVec hit = v & once;
+            LaneVec next = (v & ~LaneVec(hit != 0)) | hit;
+            // две "единственные" цифры в одной клетке - противоречие
+            lanes.dead |= LaneVec((hit & (hit - 1)) != 0);
+            changed |= next ^ v;
+            lanes.cand[units.cells[unit][k]] = next;
+        }
+    }
+    return AnyAlive(changed, lanes.dead);
+}
+
+void Propagate(LaneBoard& lanes, bool hidden_singles)
+{
+    while (true)
+    {
+        if (NakedSingles(lanes)) continue;
+        if (not hidden_singles or not HiddenSingles(lanes)) break;
+    }
+}
+
+// Для каждой дорожки: решена ли доска одиночками
+void Solved(const LaneBoard& lanes, bool* solved)
+{
+    LaneVec open = {};
+    for (int index = 0; index < 81; index += 1)
+    {
+        LaneVec v = lanes.cand[index];
+        open |= v & (v - 1);
+    }
+    for (int lane = 0; lane < lane_count; lane += 1)
+    {
+        solved[lane] = (open[lane] == 0) and (lanes.dead[lane] == 0);
+    }
+}
+
+// Число кандидатов во всех дорожках сразу
+LaneVec Count(LaneVec v)
+{
+    v = v - ((v >> 1) & 0x5555);
+    v = (v & 0x3333) + ((v >> 2) & 0x3333);
+    v = (v + (v >> 4)) & 0x0F0F;
+    return (v + (v >> 8)) & 0x1F;
+}
+
+// Доска, которую одиночки не решили: кандидаты после распространения
+// и число найденных перебором решений
+struct LaneTask
+{
+    uint16_t cand[81];
+    int found;
+};
+
+// Точка ветвления: кандидаты до выбора цифры и ещё не испробованные цифры
+struct Frame
+{
+    uint16_t cand[81];
+    int cell;
+    uint16_t rest;
+};
+
+// Перебор в дорожках: каждая дорожка ведёт свой поиск с возвратом,
+// распространение одиночек идёт по всем дорожкам сразу. Дорожка, чья доска
+// досчитана (limit решений или перебор исчерпан), берёт следующую.
+void Search(LaneTask* tasks, int count, int limit)
+{
+    LaneBoard lanes;
+    int task[lane_count];
+    std::vector<Frame> stacks[lane_count];
+    int next = 0;
+    int busy = 0;
+
+    auto take = [&](int lane)
+    {
+        stacks[lane].clear();
+        if (next == count)
+        {
+            task[lane] = -1;
+            lanes.dead[lane] = 0xFFFF;
+            return;
+        }
+        task[lane] = next;
+        for (int index = 0; index < 81; index += 1) lanes.cand[index][lane] = tasks[next].cand[index];
+        lanes.dead[lane] = 0;
+        next += 1;
+        busy += 1;
+    };
+    auto backtrack = [&](int lane)
+    {
+        std::vector<Frame>& stack = stacks[lane];
+        if (stack.empty()) return false;
+        Frame& frame = stack.back();
+        uint16_t digit = frame.rest & -frame.rest;
+        frame.rest ^= digit;
+        for (int index = 0; index < 81; index += 1) lanes.cand[index][lane] = frame.cand[index];
+        lanes.cand[frame.cell][lane] = digit;
+        lanes.dead[lane] = 0;
+        if (frame.rest == 0) stack.pop_back();
+        return true;
+    };
+
+    for (int lane = 0; lane < lane_count; lane += 1) take(lane);
+
+    while (busy > 0)
+    {
+        Propagate(lanes, true);
+        bool solved[lane_count];
+        Solved(lanes, solved);
+
+        LaneVec counts[81];
+        for (int index = 0; index < 81; index += 1) counts[index] = Count(lanes.cand[index]);
+
+        for (int lane = 0; lane < lane_count; lane += 1)
+        {
+            if (task[lane] < 0) continue;
+
+            if (not solved[lane] and not lanes.dead[lane])
+            {
+                // ветвимся по клетке с наименьшим числом кандидатов
+                int best = -1;
+                int best_count = 10;
+                for (int index = 0; index < 81; index += 1)
+                {
+                    int n = counts[index][lane];
+                    if ((n > 1) and (n < best_count))
+                    {
+                        best = index;
+                        best_count = n;
+                    }
+                }
+                Frame frame;
+                for (int index = 0; index < 81; index += 1) frame.cand[index] = lanes.cand[index][lane];
+                uint16_t free = frame.cand[best];
+                uint16_t digit = free & -free;
+                frame.cell = best;
+                frame.rest = free ^ digit;
+                stacks[lane].push_back(frame);
+                lanes.cand[best][lane] = digit;
+                continue;
+            }
+
+            if (solved[lane])
+            {
+                tasks[task[lane]].found += 1;
+                if (tasks[task[lane]].found >= limit)
+                {
+                    busy -= 1;
+                    take(lane);
+                    continue;
+                }
+            }
+            if (not backtrack(lane))
+            {
+                busy -= 1;
+                take(lane);
+            }
+        }
+    }
+}
+
+// Кандидаты дорожки - в задачу для перебора
+void Extract(const LaneBoard& lanes, int lane, LaneTask& task)
+{
+    for (int index = 0; index < 81; index += 1) task.cand[index] = lanes.cand[index][lane];
+    task.found = 0;
+}
+
+}
+
+void RateBatch(const Board* boards, int count, Grade* grades)
+{
+    std::vector<LaneTask> tasks;
+    std::vector<int> hard;
+    for (int first = 0; first < count; first += lane_count)
+    {
+        int chunk = count - first < lane_count ? count - first : lane_count;
+        LaneBoard lanes;
+        Load(boards + first, chunk, lanes);
+
+        bool easy[lane_count];
+        bool medium[lane_count];
+        Propagate(lanes, false);
+        Solved(lanes, easy);
+        Propagate(lanes, true);
+        Solved(lanes, medium);
+
+        for (int lane = 0; lane < chunk; lane += 1)
+        {
+            Grade& grade = grades[first + lane];
+            if (easy[lane]) grade = Grade::Easy;
+            else if (medium[lane]) grade = Grade::Medium;
+            else if (lanes.dead[lane]) grade = Grade::Invalid;
+            else
+            {
+                tasks.emplace_back();
+                Extract(lanes, lane, tasks.back());
+                hard.push_back(first + lane);
+            }
+        }
+    }
+
+    Search(tasks.data(), int(tasks.size()), 1);
+    for (size_t k = 0; k < tasks.size(); k += 1)
+    {
+        grades[hard[k]] = tasks[k].found ? Grade::Hard : Grade::Invalid;
+    }
+}
+
+void ValidateBatch(const Board* boards, int count, Validity* results)
+{
+    std::vector<LaneTask> tasks;
+    std::vector<int> open;
+    for (int first = 0; first < count; first += lane_count)
+    {
+        int chunk = count - first < lane_count ? count - first : lane_count;
+        LaneBoard lanes;
+        Load(boards + first, chunk, lanes);
+
+        bool solved[lane_count];
+        Propagate(lanes, true);
+        Solved(lanes, solved);
+
+        for (int lane = 0; lane < chunk; lane += 1)
+        {
+            const Board& board = boards[first + lane];
+            Validity& result = results[first + lane];
+            // одиночки - вынужденные ходы, поэтому найденное ими решение единственно
+            if (solved[lane]) result = Validity::Unique;
+            else if (lanes.dead[lane]) result = HasConflict(board) ? Validity::Conflict : Validity::NoSolution;
+            else
+            {
+                tasks.emplace_back();
+                Extract(lanes, lane, tasks.back());
+                open.push_back(first + lane);
+            }
+        }
+    }
+
+    Search(tasks.data(), int(tasks.size()), 2);
+    for (size_t k = 0; k < tasks.size(); k += 1)
+    {
+        int found = tasks[k].found;
+        results[open[k]] = found == 0 ? Validity::NoSolution : found == 1 ? Validity::Unique : Validity::Multiple;
+    }
+}
+
+}
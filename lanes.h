@@ -0,0 +1,25 @@
+#pragma once
+
+#include "engine.h"
+
+// Пакетная оценка и проверка: до lane_count досок решаются одновременно.
+// Кандидаты клетки для всех досок лежат в одном векторе (uint16_t на доску),
+// и исключение по строкам, столбцам и квадратам идёт сразу по всем дорожкам
+// векторными инструкциями (расширение vector_size GCC/Clang). Доски, которые
+// не решаются одиночками, досчитываются перебором тоже в дорожках: у каждой
+// свой стек ветвлений, а распространение после каждого шага общее. Дорожки
+// без работы маскируются и сразу получают следующую доску.
+namespace Engine
+{
+
+// Одна дорожка - uint16_t: 16 досок в 256-битном регистре AVX2, иначе 8 в SSE/NEON
+#if defined(__AVX2__)
+constexpr int lane_count = 16;
+#else
+constexpr int lane_count = 8;
+#endif
+
+void RateBatch(const Board* boards, int count, Grade* grades);
+void ValidateBatch(const Board* boards, int count, Validity* results);
+
+}
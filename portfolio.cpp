@@ -0,0 +1,438 @@
+#include "portfolio.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace Engine
+{
+
+namespace
+{
+
+constexpr int min_races = 8;      // столько гонок в корзине, прежде чем выбирать
+constexpr int explore_every = 16; // каждый такой вызов всё равно гонка
+constexpr int min_budget_us = 2000;
+constexpr double mean_weight = 0.2;
+
+// Точное покрытие (алгоритм X на танцующих ссылках): 324 условия
+// (клетка, цифра в строке, в столбце, в квадрате) и 729 вариантов
+class ExactCover
+{
+public:
+    ExactCover()
+    {
+        const int columns = 4 * 81;
+        const int nodes = 1 + columns + 729 * 4;
+        _left.resize(nodes);
+        _right.resize(nodes);
+        _up.resize(nodes);
+        _down.resize(nodes);
+        _column.resize(nodes);
+        _row.resize(nodes, -1);
+        _size.assign(columns + 1, 0);
+
+        for (int c = 0; c <= columns; c += 1)
+        {
+            _left[c] = c == 0 ? columns : c - 1;
+            _right[c] = c == columns ? 0 : c + 1;
+            _up[c] = c;
+            _down[c] = c;
+            _column[c] = c;
+        }
+
+        int node = columns + 1;
+        for (int row = 0; row < 729; row += 1)
+        {
+            int r = row / 81;
+            int c = row / 9 % 9;
+            int d = row % 9;
+            int targets[4] = {1 + r * 9 + c, 1 + 81 + r * 9 + d, 1 + 162 + c * 9 + d, 1 + 243 + (r / 3 * 3 + c / 3) * 9 + d};
+            _first[row] = node;
+            for (int k = 0; k < 4; k += 1)
+            {
+                int col = targets[k];
+                _column[node] = col;
+                _row[node] = row;
+                _up[node] = _up[col];
+                _down[node] = col;
+                _down[_up[col]] = node;
+                _up[col] = node;
+                _size[col] += 1;
+                _left[node] = k == 0 ? node + 3 : node - 1;
+                _right[node] = k == 3 ? node - 3 : node + 1;
+                node += 1;
+            }
+        }
+    }
+
+    bool Solve(Board& board, const std::atomic<bool>* stop)
+    {
+        for (int r = 0; r < 9; r += 1)
+        {
+            for (int c = 0; c < 9; c += 1)
+            {
+                if (not board.locked[r][c]) continue;
+                int digit = board.digits[r][c];
+                if ((digit < 1) or (digit > 9)) return false;
+                int first = _first[r * 81 + c * 9 + digit - 1];
+                int node = first;
+                do
+                {
+                    // условие уже закрыто другой подсказкой - противоречие
+                    if (_right[_left[_column[node]]] != _column[node]) return false;
+                    node = _right[node];
+                }
+                while (node != first);
+                do
+                {
+                    Cover(_column[node]);
+                    node = _right[node];
+                }
+                while (node != first);
+                _solution.push_back(_row[first]);
+            }
+        }
+
+        _stop = stop;
+        if (not Search()) return false;
+        for (int row : _solution)
+        {
+            board.digits[row / 81][row / 9 % 9] = row % 9 + 1;
+        }
+        return true;
+    }
+private:
+    void Cover(int c)
+    {
+        _right[_left[c]] = _right[c];
+        _left[_right[c]] = _left[c];
+        for (int i = _down[c]; i != c; i = _down[i])
+        {
+            for (int j = _right[i]; j != i; j = _right[j])
+            {
+                _down[_up[j]] = _down[j];
+                _up[_down[j]] = _up[j];
+                _size[_column[j]] -= 1;
+            }
+        }
+    }
+
+    void Uncover(int c)
+    {
+        for (int i = _up[c]; i != c; i = _up[i])
+        {
+            for (int j = _left[i]; j != i; j = _left[j])
+            {
+                _size[_column[j]] += 1;
+                _down[_up[j]] = j;
+                _up[_down[j]] = j;
+            }
+        }
+        _right[_left[c]] = c;
+        _left[_right[c]] = c;
+    }
+
+    bool Search()
+    {
+        if (_right[0] == 0) return true;
+        if (_stop and _stop->load(std::memory_order_relaxed)) return false;
+
+        int best = _right[0];
+        for (int c = _right[best]; c != 0; c = _right[c])
+        {
+            if (_size[c] < _size[best]) best = c;
+        }
+        if (_size[best] == 0) return false;
+
+        Cover(best);
+        for (int i = _down[best]; i != best; i = _down[i])
+        {
+            _solution.push_back(_row[i]);
+            for (int j = _right[i]; j != i; j = _right[j]) Cover(_column[j]);
+            // после успеха матрица не восстанавливается: объект одноразовый
+            if (Search()) return true;
+            for (int j = _left[i]; j != i; j = _left[j]) Uncover(_column[j]);
+            _solution.pop_back();
+        }
+        Uncover(best);
+        return false;
+    }
+
+    std::vector<int> _left;
+    std::vector<int> _right;
+    std::vector<int> _up;
+    std::vector<int> _down;
+    std::vector<int> _column;
+    std::vector<int> _row;
+    std::vector<int> _size;
+    int _first[729];
+    std::vector<int> _solution;
+    const std::atomic<bool>* _stop = nullptr;
+};
+
+// Потоки для догоняющих решателей, общие для всех Portfolio. Они же
+// выполняют отложенные задачи: запуск догоняющих, когда вышел бюджет.
+class Workers
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    Workers()
+    {
+        int count = std::max<int>(Portfolio::backend_count - 1, std::thread::hardware_concurrency());
+        for (int i = 0; i < count; i += 1) _threads.emplace_back(&Workers::Loop, this);
+    }
+
+    ~Workers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _quit = true;
+        }
+        _wake.notify_all();
+        for (std::thread& thread : _threads) thread.join();
+    }
+
+    void Post(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _tasks.push_back(std::move(task));
+        }
+        _wake.notify_one();
+    }
+
+    void PostAt(Clock::time_point when, std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _timers.emplace(when, std::move(task));
+        }
+        _wake.notify_one();
+    }
+private:
+    void Loop()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (not _quit)
+        {
+            if (not _timers.empty() and (_timers.begin()->first <= Clock::now()))
+            {
+                _tasks.push_back(std::move(_timers.begin()->second));
+                _timers.erase(_timers.begin());
+            }
+            if (_tasks.empty())
+            {
+                if (_timers.empty()) _wake.wait(lock);
+                else _wake.wait_until(lock, _timers.begin()->first);
+                continue;
+            }
+
+            std::function<void()> task = std::move(_tasks.front());
+            _tasks.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::deque<std::function<void()>> _tasks;
+    std::multimap<Clock::time_point, std::function<void()>> _timers;
+    std::vector<std::thread> _threads;
+    bool _quit = false;
+};
+
+Workers& SharedWorkers()
+{
+    static Workers workers;
+    return workers;
+}
+
+// Общее состояние одной гонки. Догоняющие держат его через shared_ptr и
+// могут доработать уже после того, как вызывающий получил ответ.
+struct Race
+{
+    std::atomic<bool> stop{false};
+    std::mutex mutex;
+    std::condition_variable done;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    bool raced = false; // запускались ли остальные способы
+    int winner = -1;
+    bool solved = false;
+    Board result;
+    double elapsed_us = 0;
+};
+
+void Run(int backend, Board board, Race& race, unsigned seed)
+{
+    bool solved = false;
+    switch (backend)
+    {
+    case Portfolio::Backtracking:
+        solved = SolveBacktracking(board, &race.stop);
+        break;
+    case Portfolio::ExactCover:
+        solved = ExactCover().Solve(board, &race.stop);
+        break;
+    case Portfolio::RandomRestart:
+    {
+        std::mt19937 rng(seed);
+        for (int restart = 0; not race.stop.load(std::memory_order_relaxed); restart += 1)
+        {
+            Board attempt = board;
+            bool stopped;
+            solved = Solve(attempt, rng, 256ll << std::min(restart, 20), &race.stop, stopped);
+            if (stopped) continue;
+            board = attempt;
+            break;
+        }
+        break;
+    }
+    }
+
+    // отрицательный ответ после отмены ничего не значит: победитель уже есть
+    if (not solved and race.stop.load()) return;
+
+    std::lock_guard<std::mutex> lock(race.mutex);
+    if (race.winner >= 0) return;
+    race.winner = backend;
+    race.solved = solved;
+    race.result = board;
+    race.elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - race.start).count();
+    race.stop = true;
+    race.done.notify_all();
+}
+
+}
+
+bool Portfolio::Solve(Board& board, bool sandbox, Backend* winner)
+{
+    const int index = BucketIndex(board, sandbox);
+    int chosen;
+    double expected_us;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Bucket& bucket = _buckets[index];
+        bucket.calls += 1;
+        chosen = (bucket.calls % explore_every == 0) ? -1 : Choose(bucket);
+        expected_us = chosen >= 0 ? bucket.mean_us[chosen] : 0;
+    }
+
+    // один способ всегда считается в вызывающем потоке, остальные - в общих
+    auto race = std::make_shared<Race>();
+    const int own = chosen >= 0 ? chosen : Backtracking;
+    auto launch_others = [board, own](const std::shared_ptr<Race>& race)
+    {
+        for (int backend = 0; backend < backend_count; backend += 1)
+        {
+            if (backend == own) continue;
+            SharedWorkers().Post([race, board, backend]
+            {
+                if (not race->stop.load()) Run(backend, board, *race, unsigned(ThreadRng()()));
+            });
+        }
+    };
+
+    if (chosen < 0)
+    {
+        race->raced = true;
+        launch_others(race);
+    }
+    else
+    {
+        // выбранный способ застрял на этой доске - догоняем остальными
+        auto budget = std::chrono::microseconds(std::max<long long>(min_budget_us, (long long)(4 * expected_us)));
+        std::weak_ptr<Race> weak = race;
+        SharedWorkers().PostAt(race->start + budget, [weak, launch_others]
+        {
+            std::shared_ptr<Race> race = weak.lock();
+            if (not race) return;
+            {
+                std::lock_guard<std::mutex> lock(race->mutex);
+                if (race->winner >= 0) return;
+                race->raced = true;
+            }
+            launch_others(race);
+        });
+    }
+
+    Run(own, board, *race, unsigned(ThreadRng()()));
+    bool raced;
+    {
+        std::unique_lock<std::mutex> lock(race->mutex);
+        race->done.wait(lock, [&race] { return race->winner >= 0; });
+        raced = race->raced;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        Bucket& bucket = _buckets[index];
+        if (raced)
+        {
+            bucket.races += 1;
+            bucket.wins[race->winner] += 1;
+        }
+        double& mean = bucket.mean_us[race->winner];
+        mean = mean == 0 ? race->elapsed_us : mean * (1 - mean_weight) + race->elapsed_us * mean_weight;
+    }
+
+    if (winner) *winner = Backend(race->winner);
+    if (race->solved) board = race->result;
+    return race->solved;
+}
+
+const char* Portfolio::BackendName(Backend backend)
+{
+    switch (backend)
+    {
+    case Backtracking: return "backtracking";
+    case ExactCover: return "exact cover";
+    case RandomRestart: return "random restart";
+    case backend_count: break;
+    }
+    return "";
+}
+
+int Portfolio::BucketIndex(const Board& board, bool sandbox)
+{
+    int clues = 0;
+    int squares[9] = {};
+    for (int row = 0; row < 9; row += 1)
+    {
+        for (int column = 0; column < 9; column += 1)
+        {
+            if (not board.locked[row][column]) continue;
+            clues += 1;
+            squares[row / 3 * 3 + column / 3] += 1;
+        }
+    }
+    int spread = *std::max_element(squares, squares + 9) - *std::min_element(squares, squares + 9);
+
+    int clue_bucket = clues < 17 ? 0 : clues < 25 ? 1 : clues < 33 ? 2 : clues < 41 ? 3 : clues < 57 ? 4 : 5;
+    int spread_bucket = spread < 3 ? 0 : spread < 6 ? 1 : 2;
+    return (clue_bucket * 3 + spread_bucket) * 2 + (sandbox ? 1 : 0);
+}
+
+int Portfolio::Choose(const Bucket& bucket)
+{
+    if (bucket.races < min_races) return -1;
+    int best = 0;
+    for (int backend = 1; backend < backend_count; backend += 1)
+    {
+        if (bucket.wins[backend] > bucket.wins[best]) best = backend;
+    }
+    // явный фаворит - не меньше трёх четвертей побед
+    return bucket.wins[best] * 4 >= bucket.races * 3 ? best : -1;
+}
+
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <mutex>
+
+#include "engine.h"
+
+namespace Engine
+{
+
+// Решает доску сразу несколькими способами, берёт первый ответ и отменяет
+// остальные. По итогам запоминает, какой способ быстрее на похожих досках
+// (число подсказок, их разброс по квадратам, доска из песочницы), и дальше
+// считает только им, в вызывающем потоке. Если он задерживается дольше
+// обычного, к нему подключаются остальные в общих фоновых потоках.
+class Portfolio
+{
+public:
+    enum Backend
+    {
+        Backtracking,  // одиночки и перебор (SolveBacktracking)
+        ExactCover,    // точное покрытие, dancing links
+        RandomRestart, // исходный Solve с рестартами
+        backend_count
+    };
+
+    // sandbox - доска собрана пользователем в режиме песочницы
+    bool Solve(Board& board, bool sandbox, Backend* winner = nullptr);
+
+    static const char* BackendName(Backend backend);
+private:
+    static constexpr int bucket_count = 6 * 3 * 2;
+
+    struct Bucket
+    {
+        long long calls = 0;
+        int races = 0;
+        int wins[backend_count] = {};
+        double mean_us[backend_count] = {}; // скользящее среднее времени победы
+    };
+
+    static int BucketIndex(const Board& board, bool sandbox);
+    static int Choose(const Bucket& bucket);
+
+    std::mutex _mutex;
+    Bucket _buckets[bucket_count];
+};
+
+}
@@ -0,0 +1,243 @@
+#include "probe.h"
+
+#include <QApplication>
+#include <QDebug>
+#include <QPainter>
+#include <QPaintEvent>
+
+namespace
+{
+constexpr qint64 frame_us = 16667; // один кадр при 60 Гц
+constexpr int heartbeat_ms = 16;
+constexpr int overlay_refresh_ticks = 15;
+}
+
+// Непрозрачный виджет поверх доски: под ним ничего не перерисовывается,
+// поэтому сам оверлей не искажает замеры
+class ProbeOverlay : public QWidget
+{
+public:
+    ProbeOverlay(GuiProbe* probe, QWidget* parent) :
+        QWidget(parent),
+        _probe{probe}
+    {
+        setAttribute(Qt::WA_OpaquePaintEvent);
+        setAttribute(Qt::WA_TransparentForMouseEvents);
+        setFixedSize(230, 90);
+        hide();
+    }
+private:
+    void paintEvent(QPaintEvent*) override
+    {
+        QPainter painter(this);
+        painter.fillRect(rect(), QColor(30, 30, 30));
+        painter.setPen(QColor(0, 255, 120));
+        QFont tmp;
+        tmp.setPixelSize(12);
+        painter.setFont(tmp);
+        painter.drawText(rect().adjusted(6, 4, -6, -4), Qt::AlignLeft | Qt::AlignTop, _probe->Summary());
+    }
+
+    GuiProbe* _probe;
+};
+
+GuiProbe::GuiProbe(QWidget* target) :
+    QObject(target),
+    _target{target},
+    _overlay{new ProbeOverlay(this, target)},
+    _heartbeat{new QTimer(this)},
+    _enabled{false},
+    _filtering{false},
+    _last_tick{0},
+    _ticks{0},
+    _frame_open{false},
+    _painting{nullptr},
+    _frame_paint{0},
+    _last_frame_paint{0},
+    _max_frame_paint{0},
+    _style_changes{0},
+    _interaction_style_changes{0},
+    _stalls{0},
+    _max_stall{0}
+{
+    _instance = this;
+    _clock.start();
+
+    _heartbeat->setTimerType(Qt::TimerType::PreciseTimer);
+    _heartbeat->setInterval(heartbeat_ms);
+    connect(_heartbeat,&QTimer::timeout,this,&GuiProbe::Tick);
+
+    QString trace_path = qEnvironmentVariable("SUDOKU_TRACE");
+    if (not trace_path.isEmpty())
+    {
+        _trace.setFileName(trace_path);
+        if (_trace.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            // закрывающая скобка не обязательна для формата Chrome trace
+            _trace.write("[\n");
+        }
+        else qWarning() << "can't open trace file" << trace_path;
+    }
+    UpdateActivity();
+}
+
+GuiProbe::~GuiProbe()
+{
+    if (_filtering) qApp->removeEventFilter(this);
+    if (_instance == this) _instance = nullptr;
+}
+
+bool GuiProbe::IsActive() const
+{
+    return _enabled or _trace.isOpen();
+}
+
+QString GuiProbe::Summary() const
+{
+    return QString("paint: %1 ms (max %2 ms)\n"
+                   "style changes: %3 (last action %4)\n"
+                   "repainted widgets: %5\n"
+                   "stalls > 1 frame: %6 (max %7 ms)")
+            .arg(_last_frame_paint / 1000.0, 0, 'f', 2)
+            .arg(_max_frame_paint / 1000.0, 0, 'f', 2)
+            .arg(_style_changes)
+            .arg(_interaction_style_changes)
+            .arg(_repainted.size())
+            .arg(_stalls)
+            .arg(_max_stall / 1000.0, 0, 'f', 1);
+}
+
+void GuiProbe::Toggle()
+{
+    _enabled = not _enabled;
+    if (_enabled)
+    {
+        _overlay->move(0, 0);
+        _overlay->raise();
+        _overlay->show();
+    }
+    else _overlay->hide();
+    UpdateActivity();
+}
+
+void GuiProbe::UpdateActivity()
+{
+    bool active = IsActive();
+    if (active and not _filtering) qApp->installEventFilter(this);
+    if (not active and _filtering) qApp->removeEventFilter(this);
+    _filtering = active;
+
+    if (active)
+    {
+        _last_tick = Now();
+        _heartbeat->start();
+    }
+    else _heartbeat->stop();
+}
+
+void GuiProbe::Tick()
+{
+    qint64 now = Now();
+    qint64 late = now - _last_tick - heartbeat_ms * 1000;
+    _last_tick = now;
+    if (late > frame_us)
+    {
+        _stalls += 1;
+        _max_stall = qMax(_max_stall, late);
+        Record("stall", now - late, late);
+    }
+
+    _ticks += 1;
+    if (_enabled and (_ticks % overlay_refresh_ticks == 0)) _overlay->update();
+}
+
+void GuiProbe::EndFrame()
+{
+    _frame_open = false;
+    _last_frame_paint = _frame_paint;
+    _max_frame_paint = qMax(_max_frame_paint, _frame_paint);
+    Record("frame", Now() - _frame_paint, _frame_paint);
+    _frame_paint = 0;
+}
+
+bool GuiProbe::eventFilter(QObject* watched, QEvent* event)
+{
+    if (not watched->isWidgetType() or (watched == _overlay)) return false;
+    QWidget* widget = static_cast<QWidget*>(watched);
+    if ((widget != _target) and not _target->isAncestorOf(widget)) return false;
+
+    switch (event->type())
+    {
+    case QEvent::MouseButtonPress:
+    case QEvent::KeyPress:
+        _repainted.clear();
+        _interaction_style_changes = 0;
+        break;
+    case QEvent::Resize:
+        if (widget == _target)
+        {
+            _repainted.clear();
+            _interaction_style_changes = 0;
+        }
+        break;
+    case QEvent::StyleChange:
+        _style_changes += 1;
+        _interaction_style_changes += 1;
+        Record("style change", Now(), 0);
+        break;
+    case QEvent::Paint:
+    {
+        if (event == _painting) return false;
+        _repainted.insert(watched);
+        if (not _frame_open)
+        {
+            _frame_open = true;
+            QTimer::singleShot(0, this, &GuiProbe::EndFrame);
+        }
+
+        // фильтр сам доставляет событие, чтобы замерить отрисовку любого
+        // виджета доски (кнопок, надписи), а не только переопределённых
+        QEvent* outer = _painting;
+        _painting = event;
+        qint64 start = Now();
+        QCoreApplication::sendEvent(watched, event);
+        qint64 duration = Now() - start;
+        _painting = outer;
+        if (not outer) _frame_paint += duration;
+        Record(QString("paint ") + widget->metaObject()->className(), start, duration);
+        return true;
+    }
+    default:
+        break;
+    }
+    return false;
+}
+
+void GuiProbe::Record(const QString& name, qint64 start, qint64 duration)
+{
+    if (not _trace.isOpen()) return;
+    _trace.write(QString("{\"name\":\"%1\",\"ph\":\"%2\",\"ts\":%3,\"dur\":%4,\"pid\":1,\"tid\":1},\n")
+                 .arg(name)
+                 .arg(duration ? "X" : "i")
+                 .arg(start)
+                 .arg(duration)
+                 .toUtf8());
+}
+
+qint64 GuiProbe::Now() const
+{
+    return _clock.nsecsElapsed() / 1000;
+}
+
+GuiProbe::Scope::Scope(const char* name) :
+    _name{name},
+    _start{-1}
+{
+    if (_instance and _instance->IsActive()) _start = _instance->Now();
+}
+
+GuiProbe::Scope::~Scope()
+{
+    if ((_start < 0) or not _instance) return;
+    _instance->Record(_name, _start, _instance->Now() - _start);
+}
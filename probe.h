@@ -0,0 +1,73 @@
+#pragma once
+
+#include <QObject>
+#include <QWidget>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QFile>
+#include <QSet>
+
+class ProbeOverlay;
+
+// Отладочные замеры GUI: время отрисовки кадра, число смен стиля
+// (setStyleSheet / re-polish), число перерисованных виджетов на одно
+// действие пользователя и зависания цикла событий дольше одного кадра.
+// F12 показывает оверлей. Если задана переменная окружения SUDOKU_TRACE,
+// все замеры пишутся в этот файл в формате Chrome trace (chrome://tracing).
+class GuiProbe : public QObject
+{
+    Q_OBJECT
+public:
+    GuiProbe(QWidget* target);
+    ~GuiProbe();
+
+    bool IsActive() const;
+    QString Summary() const;
+
+    // Замер участка кода для трассировки
+    class Scope
+    {
+    public:
+        Scope(const char* name);
+        ~Scope();
+    private:
+        const char* _name;
+        qint64 _start;
+    };
+public slots:
+    void Toggle();
+private slots:
+    void Tick();
+    void EndFrame();
+private:
+    bool eventFilter(QObject* watched, QEvent* event) override;
+    void UpdateActivity();
+    void Record(const QString& name, qint64 start, qint64 duration);
+    qint64 Now() const;
+
+    static inline GuiProbe* _instance = nullptr;
+
+    QWidget* _target;
+    ProbeOverlay* _overlay;
+    QTimer* _heartbeat;
+    QElapsedTimer _clock;
+    QFile _trace;
+    bool _enabled;
+    bool _filtering;
+
+    qint64 _last_tick;
+    int _ticks;
+
+    bool _frame_open;
+    QEvent* _painting; // событие отрисовки, которое сейчас отправляет фильтр
+    qint64 _frame_paint;
+    qint64 _last_frame_paint;
+    qint64 _max_frame_paint;
+
+    int _style_changes;
+    int _interaction_style_changes;
+    QSet<QObject*> _repainted;
+
+    int _stalls;
+    qint64 _max_stall;
+};
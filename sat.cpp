@@ -0,0 +1,562 @@
+#include "sat.h"
+
+#include <algorithm>
+
+namespace Engine
+{
+
+namespace
+{
+constexpr int restart_base = 100;
+constexpr size_t min_learnts = 2000;
+
+double Luby(int i)
+{
+    int size = 1;
+    int seq = 0;
+    while (size < i + 1)
+    {
+        seq += 1;
+        size = 2 * size + 1;
+    }
+    while (size - 1 != i)
+    {
+        size = (size - 1) >> 1;
+        seq -= 1;
+        i = i % size;
+    }
+    return double(1ll << seq);
+}
+}
+
+int SatSolver::NewVar()
+{
+    int var = int(_assigns.size());
+    _assigns.push_back(undef);
+    _level.push_back(0);
+    _reason.push_back(no_reason);
+    _phase.push_back(0);
+    _seen.push_back(0);
+    _activity.push_back(0);
+    _heap_index.push_back(-1);
+    _watches.emplace_back();
+    _watches.emplace_back();
+    HeapInsert(var);
+    return var + 1;
+}
+
+int SatSolver::VarCount() const
+{
+    return int(_assigns.size());
+}
+
+SatSolver::Lit SatSolver::ToLit(int dimacs)
+{
+    return dimacs > 0 ? Lit(dimacs - 1) * 2 : Lit(-dimacs - 1) * 2 + 1;
+}
+
+int8_t SatSolver::LitValue(Lit lit) const
+{
+    int8_t value = _assigns[lit >> 1];
+    return (lit & 1) ? -value : value;
+}
+
+SatSolver::CRef SatSolver::Alloc(const std::vector<Lit>& lits)
+{
+    CRef cref = CRef(_arena.size());
+    _arena.push_back(uint32_t(lits.size()));
+    _arena.insert(_arena.end(), lits.begin(), lits.end());
+    return cref;
+}
+
+uint32_t SatSolver::Size(CRef cref) const
+{
+    return _arena[cref];
+}
+
+SatSolver::Lit* SatSolver::Lits(CRef cref)
+{
+    return &_arena[cref + 1];
+}
+
+void SatSolver::Attach(CRef cref)
+{
+    Lit* lits = Lits(cref);
+    _watches[lits[0]].push_back({cref, lits[1]});
+    _watches[lits[1]].push_back({cref, lits[0]});
+}
+
+void SatSolver::AddClause(const std::vector<int>& dimacs)
+{
+    if (not _ok) return;
+
+    std::vector<Lit> lits;
+    for (int value : dimacs)
+    {
+        Lit lit = ToLit(value);
+        if (LitValue(lit) == yes) return;
+        if (LitValue(lit) == no) continue;
+        if (std::find(lits.begin(), lits.end(), lit ^ 1) != lits.end()) return;
+        if (std::find(lits.begin(), lits.end(), lit) == lits.end()) lits.push_back(lit);
+    }
+
+    if (lits.empty())
+    {
+        _ok = false;
+        return;
+    }
+    if (lits.size() == 1)
+    {
+        Enqueue(lits[0], no_reason);
+        return;
+    }
+    CRef cref = Alloc(lits);
+    _clauses.push_back(cref);
+    Attach(cref);
+}
+
+void SatSolver::Enqueue(Lit lit, CRef reason)
+{
+    int var = int(lit >> 1);
+    _assigns[var] = (lit & 1) ? no : yes;
+    _level[var] = DecisionLevel();
+    _reason[var] = reason;
+    _trail.push_back(lit);
+}
+
+SatSolver::CRef SatSolver::Propagate()
+{
+    while (_qhead < _trail.size())
+    {
+        Lit false_lit = _trail[_qhead] ^ 1;
+        _qhead += 1;
+        std::vector<Watcher>& ws = _watches[false_lit];
+
+        size_t i = 0;
+        size_t j = 0;
+        while (i < ws.size())
+        {
+            if (LitValue(ws[i].blocker) == yes)
+            {
+                ws[j++] = ws[i++];
+                continue;
+            }
+
+            CRef cref = ws[i].cref;
+            Lit* lits = Lits(cref);
+            uint32_t size = Size(cref);
+            if (lits[0] == false_lit) std::swap(lits[0], lits[1]);
+            i += 1;
+
+            Watcher watcher{cref, lits[0]};
+            if (LitValue(lits[0]) == yes)
+            {
+                ws[j++] = watcher;
+                continue;
+            }
+
+            bool moved = false;
+            for (uint32_t k = 2; k < size; k += 1)
+            {
+                if (LitValue(lits[k]) != no)
+                {
+                    std::swap(lits[1], lits[k]);
+                    _watches[lits[1]].push_back(watcher);
+                    moved = true;
+                    break;
+                }
+            }
+            if (moved) continue;
+
+            ws[j++] = watcher;
+            if (LitValue(lits[0]) == no)
+            {
+                while (i < ws.size()) ws[j++] = ws[i++];
+                ws.resize(j);
+                _qhead = _trail.size();
+                return cref;
+            }
+            Enqueue(lits[0], cref);
+        }
+        ws.resize(j);
+    }
+    return no_reason;
+}
+
+void SatSolver::Analyze(CRef conflict, std::vector<Lit>& learnt, int& backjump_level)
+{
+    learnt.clear();
+    learnt.push_back(0); // место для литерала первой UIP
+
+    int path_count = 0;
+    Lit p = 0;
+    bool first = true;
+    size_t index = _trail.size();
+
+    do
+    {
+        Lit* lits = Lits(conflict);
+        uint32_t size = Size(conflict);
+        for (uint32_t k = first ? 0 : 1; k < size; k += 1)
+        {
+            int var = int(lits[k] >> 1);
+            if (_seen[var] or (_level[var] == 0)) continue;
+            _seen[var] = 1;
+            Bump(var);
+            if (_level[var] >= DecisionLevel()) path_count += 1;
+            else learnt.push_back(lits[k]);
+        }
+        first = false;
+
+        do
+        {
+            index -= 1;
+        }
+        while (not _seen[_trail[index] >> 1]);
+        p = _trail[index];
+        conflict = _reason[p >> 1];
+        _seen[p >> 1] = 0;
+        path_count -= 1;
+    }
+    while (path_count > 0);
+    learnt[0] = p ^ 1;
+
+    backjump_level = 0;
+    size_t max_index = 1;
+    for (size_t k = 1; k < learnt.size(); k += 1)
+    {
+        _seen[learnt[k] >> 1] = 0;
+        if (_level[learnt[k] >> 1] > backjump_level)
+        {
+            backjump_level = _level[learnt[k] >> 1];
+            max_index = k;
+        }
+    }
+    if (learnt.size() > 1) std::swap(learnt[1], learnt[max_index]);
+}
+
+void SatSolver::Backtrack(int level)
+{
+    if (DecisionLevel() <= level) return;
+    for (size_t k = _trail.size(); k > size_t(_trail_lim[level]); k -= 1)
+    {
+        Lit lit = _trail[k - 1];
+        int var = int(lit >> 1);
+        _phase[var] = char(lit & 1);
+        _assigns[var] = undef;
+        _reason[var] = no_reason;
+        if (_heap_index[var] < 0) HeapInsert(var);
+    }
+    _trail.resize(_trail_lim[level]);
+    _trail_lim.resize(level);
+    _qhead = _trail.size();
+}
+
+int SatSolver::DecisionLevel() const
+{
+    return int(_trail_lim.size());
+}
+
+SatSolver::Lit SatSolver::PickBranch()
+{
+    while (not _heap.empty())
+    {
+        int var = HeapPop();
+        if (_assigns[var] == undef) return Lit(var) * 2 + Lit(_phase[var] ? 1 : 0);
+    }
+    return UINT32_MAX;
+}
+
+SatSolver::Result SatSolver::Search(long long budget, long long conflict_limit, const std::atomic<bool>* stop)
+{
+    std::vector<Lit> learnt;
+    while (true)
+    {
+        CRef conflict = Propagate();
+        if (conflict != no_reason)
+        {
+            _conflicts += 1;
+            budget -= 1;
+            if (DecisionLevel() == 0) return Result::Unsat;
+
+            int backjump_level = 0;
+            Analyze(conflict, learnt, backjump_level);
+            Backtrack(backjump_level);
+            if (learnt.size() == 1) Enqueue(learnt[0], no_reason);
+            else
+            {
+                CRef cref = Alloc(learnt);
+                _learnts.push_back(cref);
+                Attach(cref);
+                Enqueue(learnt[0], cref);
+            }
+            _activity_inc /= 0.95;
+            continue;
+        }
+
+        if ((conflict_limit >= 0) and (_conflicts >= conflict_limit)) return Result::Unknown;
+        if (stop and stop->load(std::memory_order_relaxed)) return Result::Unknown;
+        if (budget <= 0)
+        {
+            Backtrack(0);
+            return Result::Unknown;
+        }
+
+        Lit next = PickBranch();
+        if (next == UINT32_MAX) return Result::Sat;
+        _trail_lim.push_back(int(_trail.size()));
+        Enqueue(next, no_reason);
+    }
+}
+
+SatSolver::Result SatSolver::Solve(long long conflict_limit, const std::atomic<bool>* stop)
+{
+    if (not _ok) return Result::Unsat;
+    if (Propagate() != no_reason)
+    {
+        _ok = false;
+        return Result::Unsat;
+    }
+
+    _max_learnts = std::max(min_learnts, _clauses.size() / 3);
+    for (int restart = 0; ; restart += 1)
+    {
+        Result result = Search((long long)(Luby(restart) * restart_base), conflict_limit, stop);
+        if (result == Result::Unsat) _ok = false;
+        if (result != Result::Unknown) return result;
+        if ((conflict_limit >= 0) and (_conflicts >= conflict_limit)) return result;
+        if (stop and stop->load(std::memory_order_relaxed)) return result;
+        if (_learnts.size() >= _max_learnts) ReduceLearnts();
+    }
+}
+
+void SatSolver::ReduceLearnts()
+{
+    // вызывается между рестартами, на нулевом уровне: причины присвоений
+    // там анализу не нужны, и любой обученный клоз можно удалить
+    for (Lit lit : _trail) _reason[lit >> 1] = no_reason;
+
+    // оставляем более короткую половину
+    std::stable_sort(_learnts.begin(), _learnts.end(), [this](CRef a, CRef b)
+    {
+        return Size(a) < Size(b);
+    });
+    _learnts.resize(_learnts.size() / 2);
+
+    std::vector<uint32_t> arena;
+    arena.reserve(_arena.size());
+    auto move = [&](CRef& cref)
+    {
+        CRef moved = CRef(arena.size());
+        arena.insert(arena.end(), _arena.begin() + cref, _arena.begin() + cref + 1 + Size(cref));
+        cref = moved;
+    };
+    for (CRef& cref : _clauses) move(cref);
+    for (CRef& cref : _learnts) move(cref);
+    _arena.swap(arena);
+
+    for (std::vector<Watcher>& ws : _watches) ws.clear();
+    for (CRef cref : _clauses) Attach(cref);
+    for (CRef cref : _learnts) Attach(cref);
+
+    _max_learnts += _max_learnts / 10;
+}
+
+bool SatSolver::Value(int var) const
+{
+    return _assigns[var - 1] == yes;
+}
+
+long long SatSolver::Conflicts() const
+{
+    return _conflicts;
+}
+
+void SatSolver::Bump(int var)
+{
+    _activity[var] += _activity_inc;
+    if (_activity[var] > 1e100)
+    {
+        for (double& activity : _activity) activity *= 1e-100;
+        _activity_inc *= 1e-100;
+    }
+    if (_heap_index[var] >= 0) HeapUp(_heap_index[var]);
+}
+
+void SatSolver::HeapInsert(int var)
+{
+    _heap_index[var] = int(_heap.size());
+    _heap.push_back(var);
+    HeapUp(_heap_index[var]);
+}
+
+void SatSolver::HeapUp(int pos)
+{
+    int var = _heap[pos];
+    while (pos > 0)
+    {
+        int parent = (pos - 1) / 2;
+        if (_activity[_heap[parent]] >= _activity[var]) break;
+        _heap[pos] = _heap[parent];
+        _heap_index[_heap[pos]] = pos;
+        pos = parent;
+    }
+    _heap[pos] = var;
+    _heap_index[var] = pos;
+}
+
+void SatSolver::HeapDown(int pos)
+{
+    int var = _heap[pos];
+    int size = int(_heap.size());
+    while (2 * pos + 1 < size)
+    {
+        int child = 2 * pos + 1;
+        if ((child + 1 < size) and (_activity[_heap[child + 1]] > _activity[_heap[child]])) child += 1;
+        if (_activity[_heap[child]] <= _activity[var]) break;
+        _heap[pos] = _heap[child];
+        _heap_index[_heap[pos]] = pos;
+        pos = child;
+    }
+    _heap[pos] = var;
+    _heap_index[var] = pos;
+}
+
+int SatSolver::HeapPop()
+{
+    int var = _heap[0];
+    _heap_index[var] = -1;
+    _heap[0] = _heap.back();
+    _heap.pop_back();
+    if (not _heap.empty())
+    {
+        _heap_index[_heap[0]] = 0;
+        HeapDown(0);
+    }
+    return var;
+}
+
+void EncodeSudoku(int box_size, const std::vector<int>& cells, std::vector<int>& cnf)
+{
+    const int n = box_size * box_size;
+    auto var = [n](int row, int column, int digit)
+    {
+        return (row * n + column) * n + digit + 1;
+    };
+    cnf.clear();
+
+    // переменные, исключённые подсказками, сразу ложны: клозы с ними
+    // не строятся, иначе для 25x25 получается больше полумиллиона пар
+    std::vector<char> live(n * n * n + 1, 1);
+    for (int index = 0; index < n * n; index += 1)
+    {
+        if (cells[index] == 0) continue;
+        int row = index / n;
+        int column = index % n;
+        int digit = cells[index] - 1;
+        int square_row = row / box_size * box_size;
+        int square_column = column / box_size * box_size;
+        for (int k = 0; k < n; k += 1)
+        {
+            if (k != digit) live[var(row, column, k)] = 0;
+            if (k != column) live[var(row, k, digit)] = 0;
+            if (k != row) live[var(k, column, digit)] = 0;
+            int r = square_row + k / box_size;
+            int c = square_column + k % box_size;
+            if ((r != row) or (c != column)) live[var(r, c, digit)] = 0;
+        }
+    }
+    for (int v = 1; v <= n * n * n; v += 1)
+    {
+        if (not live[v]) cnf.insert(cnf.end(), {-v, 0});
+    }
+
+    std::vector<int> clause;
+    auto exactly_one = [&](const int* vars)
+    {
+        clause.clear();
+        for (int k = 0; k < n; k += 1)
+        {
+            if (live[vars[k]]) clause.push_back(vars[k]);
+        }
+        cnf.insert(cnf.end(), clause.begin(), clause.end());
+        cnf.push_back(0);
+        for (size_t k1 = 0; k1 < clause.size(); k1 += 1)
+        {
+            for (size_t k2 = k1 + 1; k2 < clause.size(); k2 += 1)
+            {
+                cnf.insert(cnf.end(), {-clause[k1], -clause[k2], 0});
+            }
+        }
+    };
+
+    int unit[4][64];
+    for (int a = 0; a < n; a += 1)
+    {
+        for (int b = 0; b < n; b += 1)
+        {
+            // в клетке (a, b) ровно одна цифра; цифра b ровно один раз
+            // в строке, столбце и квадрате номер a
+            for (int k = 0; k < n; k += 1)
+            {
+                unit[0][k] = var(a, b, k);
+                unit[1][k] = var(a, k, b);
+                unit[2][k] = var(k, a, b);
+                unit[3][k] = var(a / box_size * box_size + k / box_size,
+                                 a % box_size * box_size + k % box_size, b);
+            }
+            for (int u = 0; u < 4; u += 1) exactly_one(unit[u]);
+        }
+    }
+}
+
+SatSolver::Result SatSolve(int box_size, std::vector<int>& cells, long long conflict_limit)
+{
+    const int n = box_size * box_size;
+    std::vector<int> cnf;
+    EncodeSudoku(box_size, cells, cnf);
+
+    SatSolver solver;
+    while (solver.VarCount() < n * n * n) solver.NewVar();
+    std::vector<int> clause;
+    for (int lit : cnf)
+    {
+        if (lit != 0)
+        {
+            clause.push_back(lit);
+            continue;
+        }
+        solver.AddClause(clause);
+        clause.clear();
+    }
+    SatSolver::Result result = solver.Solve(conflict_limit);
+    if (result != SatSolver::Result::Sat) return result;
+
+    for (int index = 0; index < n * n; index += 1)
+    {
+        for (int d = 0; d < n; d += 1)
+        {
+            if (solver.Value(index * n + d + 1))
+            {
+                cells[index] = d + 1;
+                break;
+            }
+        }
+    }
+    return result;
+}
+
+void WriteDimacs(int box_size, const std::vector<int>& cells, std::ostream& out)
+{
+    const int n = box_size * box_size;
+    std::vector<int> cnf;
+    EncodeSudoku(box_size, cells, cnf);
+
+    out << "p cnf " << n * n * n << " " << std::count(cnf.begin(), cnf.end(), 0) << "\n";
+    for (int lit : cnf)
+    {
+        out << lit << (lit == 0 ? "\n" : " ");
+    }
+}
+
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace Engine
+{
+
+// CDCL SAT-решатель без внешних зависимостей: два наблюдаемых литерала,
+// обучение по первой UIP, VSIDS, сохранение фаз и рестарты по Luby.
+// Клозы лежат подряд в одном массиве (арене), ссылка на клоз - смещение.
+// Литералы в интерфейсе - как в DIMACS: +v / -v, переменные с 1.
+class SatSolver
+{
+public:
+    enum class Result
+    {
+        Sat,
+        Unsat,
+        Unknown // превышен лимит конфликтов или выставлен stop
+    };
+
+    int NewVar();
+    int VarCount() const;
+
+    // Клозы добавляются только до вызова Solve
+    void AddClause(const std::vector<int>& lits);
+
+    Result Solve(long long conflict_limit = -1, const std::atomic<bool>* stop = nullptr);
+
+    // Значение переменной в найденном решении
+    bool Value(int var) const;
+
+    long long Conflicts() const;
+private:
+    using Lit = uint32_t;
+    using CRef = uint32_t;
+    static constexpr CRef no_reason = UINT32_MAX;
+    static constexpr int8_t undef = 0;
+    static constexpr int8_t yes = 1;
+    static constexpr int8_t no = -1;
+
+    struct Watcher
+    {
+        CRef cref;
+        Lit blocker;
+    };
+
+    static Lit ToLit(int dimacs);
+
+    int8_t LitValue(Lit lit) const;
+    CRef Alloc(const std::vector<Lit>& lits);
+    uint32_t Size(CRef cref) const;
+    Lit* Lits(CRef cref);
+
+    void Attach(CRef cref);
+    void Enqueue(Lit lit, CRef reason);
+    CRef Propagate();
+    void Analyze(CRef conflict, std::vector<Lit>& learnt, int& backjump_level);
+    void Backtrack(int level);
+    int DecisionLevel() const;
+    Lit PickBranch();
+    Result Search(long long budget, long long conflict_limit, const std::atomic<bool>* stop);
+    void ReduceLearnts();
+
+    void Bump(int var);
+    void HeapInsert(int var);
+    void HeapUp(int pos);
+    void HeapDown(int pos);
+    int HeapPop();
+
+    std::vector<uint32_t> _arena; // [размер, литералы...]
+    std::vector<CRef> _clauses;
+    std::vector<CRef> _learnts;
+    size_t _max_learnts = 0;
+    std::vector<std::vector<Watcher>> _watches; // по литералу
+
+    std::vector<int8_t> _assigns;
+    std::vector<int> _level;
+    std::vector<CRef> _reason;
+    std::vector<char> _phase;
+    std::vector<char> _seen;
+    std::vector<Lit> _trail;
+    std::vector<int> _trail_lim;
+    size_t _qhead = 0;
+
+    std::vector<double> _activity;
+    double _activity_inc = 1;
+    std::vector<int> _heap;
+    std::vector<int> _heap_index; // -1 - не в куче
+
+    long long _conflicts = 0;
+    bool _ok = true;
+};
+
+// Судоку box_size^2 x box_size^2 (3 - обычное, 4 - 16x16, 5 - 25x25).
+// cells - построчно, 0 - пустая клетка, остальные - подсказки.
+// Клозы записываются в cnf подряд, каждый заканчивается нулём, как в DIMACS;
+// противоречивые подсказки дают пустой клоз.
+void EncodeSudoku(int box_size, const std::vector<int>& cells, std::vector<int>& cnf);
+
+// При Sat заполняет cells. Unknown - не хватило conflict_limit конфликтов
+// (conflict_limit < 0 - без ограничения).
+SatSolver::Result SatSolve(int box_size, std::vector<int>& cells, long long conflict_limit = -1);
+
+void WriteDimacs(int box_size, const std::vector<int>& cells, std::ostream& out);
+
+}
@@ -0,0 +1,307 @@
+#include "server.h"
+#include "engine.h"
+#include "sat.h"
+#include "lanes.h"
+
+#include <unistd.h>
+
+namespace
+{
+// SOLVEN не должен занимать поток пула надолго: на обычных досках
+// решателю хватает нескольких тысяч конфликтов
+constexpr long long solven_conflict_limit = 200000;
+
+// самый длинный запрос - SOLVEN для 25x25, около 640 байт
+constexpr qint64 max_line_size = 4096;
+}
+
+SdkServer::SdkServer(int batch_size, QObject* parent) :
+    QObject(parent),
+    _server{new QLocalServer(this)},
+    _flush_timer{new QTimer(this)},
+    _pool{QThreadPool::globalInstance()},
+    _batch_size{batch_size > 0 ? batch_size : 1}
+{
+    // таймер с нулевым интервалом срабатывает, когда цикл событий разобрал
+    // все готовые сокеты, - к этому моменту пачка собрана со всех подключений
+    _flush_timer->setSingleShot(true);
+    _flush_timer->setInterval(0);
+    connect(_flush_timer,&QTimer::timeout,this,&SdkServer::Flush);
+    connect(_server,&QLocalServer::newConnection,this,&SdkServer::NewConnection);
+}
+
+SdkServer::~SdkServer()
+{
+    _pool->waitForDone();
+}
+
+bool SdkServer::Listen(const QString& name)
+{
+    // файл сокета мог остаться от упавшего сервера - его можно удалить,
+    // но у живого сервера сокет отбирать нельзя
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if (probe.waitForConnected(100))
+    {
+        _error = "another server is already listening";
+        return false;
+    }
+    QLocalServer::removeServer(name);
+    if (not _server->listen(name)) return false;
+
+    // прогреваем пул, чтобы первые запросы не ждали создания потоков
+    for (int i = 0; i < _pool->maxThreadCount(); i += 1)
+    {
+        _pool->start([]
+        {
+            Engine::Board board;
+            Engine::Generate(board, 30, Engine::ThreadRng());
+            Engine::Validate(board);
+        });
+    }
+    return true;
+}
+
+QString SdkServer::ErrorString() const
+{
+    return _error.isEmpty() ? _server->errorString() : _error;
+}
+
+void SdkServer::NewConnection()
+{
+    while (QLocalSocket* socket = _server->nextPendingConnection())
+    {
+        Connection connection;
+        connection.descriptor = ::dup(int(socket->socketDescriptor()));
+        _connections.insert(socket, connection);
+        connect(socket,&QLocalSocket::readyRead,this,&SdkServer::ReadRequests);
+        connect(socket,&QLocalSocket::disconnected,this,&SdkServer::Disconnected);
+    }
+}
+
+void SdkServer::ReadRequests()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+    if (not socket) return;
+    Connection& connection = _connections[socket];
+
+    while (socket->canReadLine())
+    {
+        QByteArray line = socket->readLine().trimmed();
+        if (line.isEmpty()) continue;
+        _pending.push_back({socket, connection.next_seq, line, {}});
+        connection.next_seq += 1;
+    }
+
+    // строка без перевода строки не должна растить буфер без конца
+    if (socket->bytesAvailable() > max_line_size)
+    {
+        Close(socket);
+        socket->abort();
+    }
+
+    if (_pending.size() >= _batch_size) Flush();
+    else if (not _pending.isEmpty() and not _flush_timer->isActive()) _flush_timer->start();
+}
+
+void SdkServer::Disconnected()
+{
+    QLocalSocket* socket = qobject_cast<QLocalSocket*>(sender());
+    if (not socket) return;
+    auto it = _connections.find(socket);
+    if (it == _connections.end()) return;
+
+    // ответы на уже принятые запросы допишет Deliver
+    if (it->write_seq != it->next_seq) it->closed = true;
+    else Close(socket);
+}
+
+void SdkServer::Close(QLocalSocket* socket)
+{
+    auto it = _connections.find(socket);
+    if (it != _connections.end())
+    {
+        if (it->descriptor >= 0) ::close(it->descriptor);
+        _connections.erase(it);
+    }
+    socket->deleteLater();
+}
+
+void SdkServer::Flush()
+{
+    _flush_timer->stop();
+    while (not _pending.isEmpty())
+    {
+        int count = qMin(_batch_size, int(_pending.size()));
+        QVector<Request> batch = _pending.mid(0, count);
+        _pending.remove(0, count);
+
+        _pool->start([this, batch]() mutable
+        {
+            HandleBatch(batch);
+            QMetaObject::invokeMethod(this, [this, batch]
+            {
+                Deliver(batch);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+void SdkServer::Deliver(QVector<Request> batch)
+{
+    QSet<QLocalSocket*> touched;
+    for (Request& request : batch)
+    {
+        if (not request.socket) continue;
+        auto it = _connections.find(request.socket.data());
+        if (it == _connections.end()) continue;
+        it->ready.insert(request.seq, request.response);
+        touched.insert(request.socket.data());
+    }
+
+    for (QLocalSocket* socket : touched)
+    {
+        Connection& connection = _connections[socket];
+        QByteArray out;
+        auto it = connection.ready.begin();
+        while ((it != connection.ready.end()) and (it.key() == connection.write_seq))
+        {
+            out += it.value();
+            out += '\n';
+            it = connection.ready.erase(it);
+            connection.write_seq += 1;
+        }
+        if (not connection.closed)
+        {
+            if (not out.isEmpty()) socket->write(out);
+            continue;
+        }
+
+        connection.unsent += out;
+        if (connection.write_seq != connection.next_seq) continue;
+
+        // все ответы готовы: отправляем через копию дескриптора, сокет сам
+        // закроется, когда допишет
+        QLocalSocket* late = new QLocalSocket(this);
+        if (late->setSocketDescriptor(connection.descriptor, QLocalSocket::ConnectedState, QIODevice::WriteOnly))
+        {
+            connection.descriptor = -1;
+            connect(late,&QLocalSocket::disconnected,late,&QObject::deleteLater);
+            late->write(connection.unsent);
+            late->disconnectFromServer();
+        }
+        else delete late;
+        Close(socket);
+    }
+}
+
+// GRADE и VALIDATE идут в векторное ядро даже поодиночке: на досках GEN 30
+// одна доска через ValidateBatch считается в 2.5 раза быстрее Validate,
+// пачка из 32 - почти в 10 раз
+void SdkServer::HandleBatch(QVector<Request>& batch)
+{
+    std::vector<Engine::Board> grade_boards;
+    std::vector<Engine::Board> validate_boards;
+    std::vector<int> grade_requests;
+    std::vector<int> validate_requests;
+
+    for (int i = 0; i < batch.size(); i += 1)
+    {
+        QByteArray command;
+        QByteArray argument;
+        Split(batch[i].line, command, argument);
+
+        Engine::Board board;
+        bool lane_command = (command == "GRADE") or (command == "VALIDATE");
+        if (not lane_command or not Engine::FromString(argument.toStdString(), board))
+        {
+            batch[i].response = Handle(batch[i].line);
+        }
+        else if (command == "GRADE")
+        {
+            grade_boards.push_back(board);
+            grade_requests.push_back(i);
+        }
+        else
+        {
+            validate_boards.push_back(board);
+            validate_requests.push_back(i);
+        }
+    }
+
+    std::vector<Engine::Grade> grades(grade_boards.size());
+    Engine::RateBatch(grade_boards.data(), int(grade_boards.size()), grades.data());
+    for (size_t k = 0; k < grades.size(); k += 1)
+    {
+        batch[grade_requests[k]].response = QByteArray("OK ") + Engine::GradeName(grades[k]);
+    }
+
+    std::vector<Engine::Validity> results(validate_boards.size());
+    Engine::ValidateBatch(validate_boards.data(), int(validate_boards.size()), results.data());
+    for (size_t k = 0; k < results.size(); k += 1)
+    {
+        batch[validate_requests[k]].response = QByteArray("OK ") + Engine::ValidityName(results[k]);
+    }
+}
+
+void SdkServer::Split(const QByteArray& line, QByteArray& command, QByteArray& argument)
+{
+    int space = line.indexOf(' ');
+    command = (space < 0 ? line : line.left(space)).toUpper();
+    argument = space < 0 ? QByteArray() : line.mid(space + 1).trimmed();
+}
+
+QByteArray SdkServer::Handle(const QByteArray& line)
+{
+    QByteArray command;
+    QByteArray argument;
+    Split(line, command, argument);
+
+    if (command == "GEN")
+    {
+        bool ok = false;
+        int open_slots_count = argument.toInt(&ok);
+        if (not ok or (open_slots_count < 0) or (open_slots_count > 81))
+        {
+            return "ERR bad open slots count";
+        }
+        Engine::Board board;
+        Engine::Generate(board, open_slots_count, Engine::ThreadRng());
+        return "OK " + QByteArray::fromStdString(Engine::ToString(board));
+    }
+
+    if (command == "SOLVEN")
+    {
+        QList<QByteArray> parts = argument.split(' ');
+        std::vector<int> cells;
+        if ((parts.size() != 2) or not Engine::FromString(parts[1].toStdString(), parts[0].toInt(), cells))
+        {
+            return "ERR bad board";
+        }
+        Engine::SatSolver::Result result = Engine::SatSolve(parts[0].toInt(), cells, solven_conflict_limit);
+        if (result == Engine::SatSolver::Result::Unsat) return "ERR no solution";
+        if (result == Engine::SatSolver::Result::Unknown) return "ERR conflict limit";
+        return "OK " + QByteArray::fromStdString(Engine::ToString(parts[0].toInt(), cells));
+    }
+
+    Engine::Board board;
+    if (not Engine::FromString(argument.toStdString(), board))
+    {
+        return "ERR bad board";
+    }
+
+    if (command == "SOLVE")
+    {
+        if (not _portfolio.Solve(board, false)) return "ERR no solution";
+        return "OK " + QByteArray::fromStdString(Engine::ToString(board));
+    }
+    if (command == "GRADE")
+    {
+        return QByteArray("OK ") + Engine::GradeName(Engine::Rate(board));
+    }
+    if (command == "VALIDATE")
+    {
+        return QByteArray("OK ") + Engine::ValidityName(Engine::Validate(board));
+    }
+    return "ERR unknown command";
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QVector>
+#include <QPointer>
+#include <QTimer>
+#include <QThreadPool>
+
+#include "portfolio.h"
+
+// Фоновый сервер: принимает запросы по unix-сокету, по одному на строку.
+//
+//   GEN <open_slots_count>  -> OK <81 символ>
+//   SOLVE <81 символ>       -> OK <81 символ> | ERR no solution (portfolio.h)
+//   GRADE <81 символ>       -> OK easy|medium|hard|invalid
+//   VALIDATE <81 символ>    -> OK unique|multiple|none|conflict
+//   SOLVEN <box> <box^4 символов> -> OK <решение> | ERR no solution
+//                              | ERR conflict limit
+//                              (доски 4x4 - 25x25, решаются SAT-решателем)
+//
+// Строки длиннее 4 КБ не принимаются: сервер закрывает подключение.
+// Клиент может отправлять запросы не дожидаясь ответов: ответы приходят
+// в том же порядке. Запросы всех подключений собираются в пачки и
+// решаются в пуле потоков; GRADE и VALIDATE из одной пачки считаются
+// вместе векторным ядром (lanes.h).
+class SdkServer : public QObject
+{
+    Q_OBJECT
+public:
+    SdkServer(int batch_size, QObject* parent = nullptr);
+    ~SdkServer();
+
+    bool Listen(const QString& name);
+    QString ErrorString() const;
+private slots:
+    void NewConnection();
+    void ReadRequests();
+    void Disconnected();
+    void Flush();
+private:
+    struct Request
+    {
+        QPointer<QLocalSocket> socket;
+        quint64 seq;
+        QByteArray line;
+        QByteArray response;
+    };
+
+    void Deliver(QVector<Request> batch);
+    void Close(QLocalSocket* socket);
+    void HandleBatch(QVector<Request>& batch);
+    QByteArray Handle(const QByteArray& line);
+    static void Split(const QByteArray& line, QByteArray& command, QByteArray& argument);
+
+    struct Connection
+    {
+        quint64 next_seq = 0;  // номер следующего запроса
+        quint64 write_seq = 0; // номер следующего ответа
+        QMap<quint64, QByteArray> ready; // ответы, пришедшие раньше очереди
+
+        // клиент может закрыть свою сторону сразу после запросов (nc -N):
+        // тогда ответы копятся в unsent и пишутся в копию дескриптора
+        int descriptor = -1;
+        bool closed = false;
+        QByteArray unsent;
+    };
+
+    QLocalServer* _server;
+    QTimer* _flush_timer;
+    QThreadPool* _pool;
+    int _batch_size;
+    QString _error;
+    Engine::Portfolio _portfolio;
+
+    QVector<Request> _pending;
+    QHash<QLocalSocket*, Connection> _connections;
+};
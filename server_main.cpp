@@ -0,0 +1,54 @@
+#include "server.h"
+#include "engine.h"
+#include "sat.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+
+#include <iostream>
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Sudoku generate/solve server");
+    parser.addHelpOption();
+    parser.addPositionalArgument("socket", "Unix socket name or path (default: sudoku.sock)");
+    QCommandLineOption threads("threads", "Worker thread count.", "count");
+    QCommandLineOption batch("batch", "Requests per worker task (default: 32).", "count", "32");
+    QCommandLineOption dimacs("dimacs", "Print the CNF encoding of a board (box size and board from the arguments) and exit.");
+    parser.addOption(threads);
+    parser.addOption(batch);
+    parser.addOption(dimacs);
+    parser.process(a);
+
+    if (parser.isSet(dimacs))
+    {
+        QStringList args = parser.positionalArguments();
+        std::vector<int> cells;
+        if ((args.size() != 2) or not Engine::FromString(args[1].toStdString(), args[0].toInt(), cells))
+        {
+            qWarning() << "usage: sdkd --dimacs <box size> <board>";
+            return 1;
+        }
+        Engine::WriteDimacs(args[0].toInt(), cells, std::cout);
+        return 0;
+    }
+
+    if (parser.isSet(threads))
+    {
+        QThreadPool::globalInstance()->setMaxThreadCount(parser.value(threads).toInt());
+    }
+
+    QString name = parser.positionalArguments().value(0, "sudoku.sock");
+    SdkServer server(parser.value(batch).toInt());
+    if (not server.Listen(name))
+    {
+        qWarning() << "can't listen on" << name << ":" << server.ErrorString();
+        return 1;
+    }
+    qInfo() << "listening on" << name;
+    return a.exec();
+}
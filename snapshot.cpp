@@ -0,0 +1,262 @@
+#include "snapshot.h"
+
+namespace
+{
+constexpr char magic[2] = {'S', 'D'};
+constexpr uint8_t version = 1;
+constexpr uint8_t sandbox_flag = 1;
+constexpr uint8_t joined_flag = 0x80;
+constexpr int locks_offset = 8;
+constexpr int digits_offset = locks_offset + 11;
+}
+
+void GameJournal::Start(const GameState& state)
+{
+    _base = state;
+    _current = state;
+    _moves.clear();
+    _cursor = 0;
+}
+
+bool GameJournal::Load(const QByteArray& data, int& size)
+{
+    if ((data.size() < snapshot_size) or (data[0] != magic[0]) or (data[1] != magic[1])
+            or (uint8_t(data[2]) != version))
+    {
+        return false;
+    }
+
+    GameState state;
+    state.sandbox_mode = uint8_t(data[3]) & sandbox_flag;
+    state.seconds = uint8_t(data[4]) | (uint8_t(data[5]) << 8);
+    state.open_slots_count = uint8_t(data[6]);
+    for (int index = 0; index < 81; index += 1)
+    {
+        int row = index / 9;
+        int column = index % 9;
+        state.board.locked[row][column] = (uint8_t(data[locks_offset + index / 8]) >> (index % 8)) & 1;
+        state.board.digits[row][column] = (uint8_t(data[digits_offset + index / 2]) >> (index % 2 * 4)) & 0xF;
+        if (state.board.digits[row][column] > 9) return false;
+    }
+    Start(state);
+
+    // недописанная последняя запись (приложение закрыли посреди записи) отбрасывается
+    size = snapshot_size;
+    for (int offset = snapshot_size; offset + record_size <= data.size(); offset += record_size)
+    {
+        size = offset + record_size;
+        Move move{Move::Type(uint8_t(data[offset]) & ~joined_flag), uint8_t(data[offset + 1]),
+                  uint8_t(uint8_t(data[offset + 2]) >> 4), uint8_t(uint8_t(data[offset + 2]) & 0xF),
+                  bool(uint8_t(data[offset]) & joined_flag)};
+        QVector<int> cells;
+        switch (move.type)
+        {
+        case Move::Digit:
+        case Move::Lock:
+            if ((move.cell >= 81) or (move.before > 9) or (move.after > 9)) return false;
+            Push(move);
+            break;
+        case Move::Undo:
+            Undo(cells);
+            break;
+        case Move::Redo:
+            Redo(cells);
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+QByteArray GameJournal::Snapshot() const
+{
+    QByteArray data(snapshot_size, '\0');
+    data[0] = magic[0];
+    data[1] = magic[1];
+    data[2] = char(version);
+    data.replace(status_offset, status_size, Status());
+    data[6] = char(_base.open_slots_count);
+    for (int index = 0; index < 81; index += 1)
+    {
+        int row = index / 9;
+        int column = index % 9;
+        if (_base.board.locked[row][column]) data[locks_offset + index / 8] = char(data[locks_offset + index / 8] | (1 << (index % 8)));
+        data[digits_offset + index / 2] = char(data[digits_offset + index / 2] | (_base.board.digits[row][column] << (index % 2 * 4)));
+    }
+    return data;
+}
+
+QByteArray GameJournal::Status() const
+{
+    QByteArray data(status_size, '\0');
+    data[0] = char(_current.sandbox_mode ? sandbox_flag : 0);
+    data[1] = char(_current.seconds & 0xFF);
+    data[2] = char(_current.seconds >> 8);
+    return data;
+}
+
+QByteArray GameJournal::Push(const Move& move)
+{
+    _moves.resize(_cursor);
+    _moves.push_back(move);
+    _cursor += 1;
+    Apply(move, true);
+    return Record(move);
+}
+
+QByteArray GameJournal::Undo(QVector<int>& cells)
+{
+    if (_cursor == 0) return {};
+    // связанные ходы откатываются до первого хода группы
+    do
+    {
+        _cursor -= 1;
+        Apply(_moves[_cursor], false);
+        cells.push_back(_moves[_cursor].cell);
+    }
+    while ((_cursor > 0) and _moves[_cursor].joined);
+    return Record({Move::Undo, 0, 0, 0});
+}
+
+QByteArray GameJournal::Redo(QVector<int>& cells)
+{
+    if (_cursor == int(_moves.size())) return {};
+    do
+    {
+        Apply(_moves[_cursor], true);
+        cells.push_back(_moves[_cursor].cell);
+        _cursor += 1;
+    }
+    while ((_cursor < int(_moves.size())) and _moves[_cursor].joined);
+    return Record({Move::Redo, 0, 0, 0});
+}
+
+const GameState& GameJournal::Current() const
+{
+    return _current;
+}
+
+void GameJournal::SetSeconds(uint16_t seconds)
+{
+    _current.seconds = seconds;
+}
+
+QByteArray GameJournal::Record(const Move& move)
+{
+    QByteArray data(record_size, '\0');
+    data[0] = char(move.type | (move.joined ? joined_flag : 0));
+    data[1] = char(move.cell);
+    data[2] = char((move.before << 4) | move.after);
+    return data;
+}
+
+void GameJournal::Apply(const Move& move, bool forward)
+{
+    int row = move.cell / 9;
+    int column = move.cell % 9;
+    uint8_t value = forward ? move.after : move.before;
+    if (move.type == Move::Digit) _current.board.digits[row][column] = value;
+    else _current.board.locked[row][column] = value;
+}
+
+class Autosave::Writer : public QObject
+{
+public:
+    Writer(const QString& path) :
+        _file{path}
+    {
+    }
+
+    void Rewrite(const QByteArray& data)
+    {
+        _file.close();
+        if (not _file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return;
+        Write(data);
+    }
+
+    // обрезает недописанную запись, иначе следующие ходы лягут со сдвигом
+    void Reopen(qint64 size)
+    {
+        _file.close();
+        if (_file.open(QIODevice::ReadWrite)) _file.resize(size);
+    }
+
+    void Append(const QByteArray& data)
+    {
+        if (not _file.isOpen()) return;
+        _file.seek(_file.size());
+        Write(data);
+    }
+
+    void Patch(int offset, const QByteArray& data)
+    {
+        if (not _file.isOpen()) return;
+        _file.seek(offset);
+        Write(data);
+    }
+
+    void Remove()
+    {
+        _file.close();
+        _file.remove();
+    }
+private:
+    void Write(const QByteArray& data)
+    {
+        _file.write(data);
+        _file.flush();
+    }
+
+    QFile _file;
+};
+
+Autosave::Autosave(const QString& path, QObject* parent) :
+    QObject(parent),
+    _path{path},
+    _thread{new QThread(this)},
+    _writer{new Writer(path)}
+{
+    _writer->moveToThread(_thread);
+    connect(_thread,&QThread::finished,_writer,&QObject::deleteLater);
+    _thread->start(QThread::LowPriority);
+}
+
+Autosave::~Autosave()
+{
+    // остановка идёт через ту же очередь, поэтому все записи успеют дойти до диска
+    QMetaObject::invokeMethod(_writer, [thread = _thread] { thread->quit(); }, Qt::QueuedConnection);
+    _thread->wait();
+}
+
+QByteArray Autosave::Read() const
+{
+    QFile file(_path);
+    if (not file.open(QIODevice::ReadOnly)) return {};
+    return file.readAll();
+}
+
+void Autosave::Rewrite(const QByteArray& data)
+{
+    QMetaObject::invokeMethod(_writer, [writer = _writer, data] { writer->Rewrite(data); }, Qt::QueuedConnection);
+}
+
+void Autosave::Reopen(qint64 size)
+{
+    QMetaObject::invokeMethod(_writer, [writer = _writer, size] { writer->Reopen(size); }, Qt::QueuedConnection);
+}
+
+void Autosave::Append(const QByteArray& data)
+{
+    QMetaObject::invokeMethod(_writer, [writer = _writer, data] { writer->Append(data); }, Qt::QueuedConnection);
+}
+
+void Autosave::Patch(int offset, const QByteArray& data)
+{
+    QMetaObject::invokeMethod(_writer, [writer = _writer, offset, data] { writer->Patch(offset, data); }, Qt::QueuedConnection);
+}
+
+void Autosave::Remove()
+{
+    QMetaObject::invokeMethod(_writer, [writer = _writer] { writer->Remove(); }, Qt::QueuedConnection);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <QObject>
+#include <QByteArray>
+#include <QVector>
+#include <QThread>
+#include <QFile>
+
+#include "engine.h"
+
+struct GameState
+{
+    Engine::Board board;
+    uint16_t seconds = 0;
+    int open_slots_count = 0;
+    bool sandbox_mode = false;
+};
+
+// Ход игрока: смена цифры или (в песочнице) блокировка клетки
+struct Move
+{
+    enum Type : uint8_t
+    {
+        Digit,
+        Lock,
+        Undo,
+        Redo
+    };
+
+    Type type;
+    uint8_t cell;   // 0 - 80, построчно
+    uint8_t before; // для Lock: 0 - открыта, 1 - заблокирована
+    uint8_t after;
+    bool joined = false; // продолжает предыдущий ход: отменяется и повторяется вместе с ним
+};
+
+// Сохранение партии: снимок начальной доски (snapshot_size байт) и журнал
+// ходов, который только дописывается (record_size байт на ход, отмену или
+// повтор). Текущее состояние получается проигрыванием журнала.
+// Запись: тип (старший бит - joined), клетка, цифры до и после по 4 бита.
+//
+// Снимок: "SD", версия, флаги, секунды (2 байта), число подсказок, резерв,
+// биты блокировок (11 байт), цифры по 4 бита (41 байт).
+class GameJournal
+{
+public:
+    static constexpr int snapshot_size = 60;
+    static constexpr int record_size = 3;
+    static constexpr int status_offset = 3; // флаги и секунды меняются на месте
+    static constexpr int status_size = 3;
+
+    void Start(const GameState& state);
+    // size - длина разобранной части: снимок и целые записи журнала
+    bool Load(const QByteArray& data, int& size);
+
+    QByteArray Snapshot() const;
+    QByteArray Status() const;
+
+    // Возвращают запись для журнала; пустая - нечего отменять/повторять.
+    // В cells добавляются клетки, изменённые отменой или повтором.
+    QByteArray Push(const Move& move);
+    QByteArray Undo(QVector<int>& cells);
+    QByteArray Redo(QVector<int>& cells);
+
+    const GameState& Current() const;
+    void SetSeconds(uint16_t seconds);
+private:
+    static QByteArray Record(const Move& move);
+    void Apply(const Move& move, bool forward);
+
+    GameState _base;
+    GameState _current;
+    QVector<Move> _moves;
+    int _cursor = 0; // ходы [0, _cursor) применены, остальные можно повторить
+};
+
+// Пишет сохранение в отдельном потоке, чтобы ход не ждал диска
+class Autosave : public QObject
+{
+    Q_OBJECT
+public:
+    Autosave(const QString& path, QObject* parent);
+    ~Autosave();
+
+    QByteArray Read() const;
+
+    void Rewrite(const QByteArray& data);
+    void Reopen(qint64 size);
+    void Append(const QByteArray& data);
+    void Patch(int offset, const QByteArray& data);
+    void Remove();
+private:
+    class Writer;
+
+    QString _path;
+    QThread* _thread;
+    Writer* _writer;
+};
@@ -1,4 +1,5 @@
 #include "sudoku.h"
+#include "engine.h"
 
 CellBtn::CellBtn(QWidget* parent) :
     QPushButton("0",parent),
@@ -48,6 +49,7 @@ void CellBtn::ChangeDigit()
 {
     if (not _is_open) return;
 
+    int before = _digit;
     _digit += 1;
     if (_digit == 10)
     {
@@ -55,6 +57,7 @@ void CellBtn::ChangeDigit()
     }
     setText(QString::number(_digit));
     UpdateColor();
+    emit DigitChanged(before, _digit);
 }
 
 void CellBtn::mousePressEvent(QMouseEvent* event)
@@ -63,12 +66,14 @@ void CellBtn::mousePressEvent(QMouseEvent* event)
     {
         if (_is_open) Lock();
         else Open();
+        emit LockChanged(not _is_open);
     }
     QPushButton::mousePressEvent(event);
 }
 
 void CellBtn::resizeEvent(QResizeEvent*)
 {
+    GuiProbe::Scope scope("cell font");
     QFont tmp;
     tmp.setPixelSize(this->height()/2);
     this->setFont(tmp);
@@ -98,7 +103,10 @@ Sudoku::Sudoku(QWidget* parent) :
     _help{new QPushButton("Help",this)},
     _timer{new QTimer(this)},
     _seconds{0},
-    _timer_lbl{new QLabel("0 second later",this)}
+    _timer_lbl{new QLabel("0 second later",this)},
+    _probe{new GuiProbe(this)},
+    _autosave{new Autosave("autosave.sdk",this)},
+    _has_game{false}
 {
     QGridLayout* main_layout = new QGridLayout(this);
     for (int i = 0; i < 9; i+=1)
@@ -108,6 +116,16 @@ Sudoku::Sudoku(QWidget* parent) :
             _cells[i][j] = new CellBtn(this);
             _cells[i][j]->setSizePolicy(QSizePolicy::Expanding , QSizePolicy::Expanding);
             main_layout->addWidget(_cells[i][j],i + i/3,j + j/3);
+
+            const uint8_t index = i * 9 + j;
+            connect(_cells[i][j],&CellBtn::DigitChanged,this,[this, index](int before, int after)
+            {
+                RecordMove({Move::Digit, index, uint8_t(before), uint8_t(after)});
+            });
+            connect(_cells[i][j],&CellBtn::LockChanged,this,[this, index](bool locked)
+            {
+                RecordMove({Move::Lock, index, uint8_t(not locked), uint8_t(locked)});
+            });
         }
     }
     main_layout->addItem(new QSpacerItem(30,30),3,3);
@@ -130,6 +148,10 @@ Sudoku::Sudoku(QWidget* parent) :
     _timer->setTimerType(Qt::TimerType::VeryCoarseTimer);
     connect(_timer,&QTimer::timeout,this,&Sudoku::Update);
 
+    connect(new QShortcut(QKeySequence(Qt::Key_F12),this),&QShortcut::activated,_probe,&GuiProbe::Toggle);
+    connect(new QShortcut(QKeySequence::Undo,this),&QShortcut::activated,this,&Sudoku::Undo);
+    connect(new QShortcut(QKeySequence::Redo,this),&QShortcut::activated,this,&Sudoku::Redo);
+
     this->setLayout(main_layout);
     setWindowTitle("Sudoku");
 }
@@ -139,345 +161,143 @@ bool Sudoku::IsSandboxMode()
     return _sandbox_mode;
 }
 
-// Данный класс нужен только для того, чтобы создавать и решать судоку
-class Cell
+bool Sudoku::Resume()
 {
-private:
-    bool _free_digits[9];
-    int _digit; // 0 - нет числа
-public:
-    Cell(const int digit = 0)
-    {
-        _digit = digit;
-        for (int i = 0; i < 9; i += 1) _free_digits[i] = true; // изначально все свободны
-    }
+    int size;
+    if (not _journal.Load(_autosave->Read(), size)) return false;
 
-    void Reset()
+    for (int index = 0; index < 81; index += 1)
     {
-        for (int i = 0; i < 9; i += 1) _free_digits[i] = true; // изначально все свободны
-        _digit = 0;
+        SyncCell(index);
     }
 
-    int GetDigit()
-    {
-        return _digit;
-    }
+    const GameState& state = _journal.Current();
+    _sandbox_mode = state.sandbox_mode;
+    _open_slots_count = state.open_slots_count;
+    _seconds = state.seconds;
+    StartGame();
 
-    void RemoveFD(int digit)
-    {
-        _free_digits[digit - 1] = false;
-    }
-
-    bool GenerateDigit()
-    {
-        int fd_count = 0;
-        for (int i = 0; i < 9; i += 1) fd_count += _free_digits[i];
-
-        if (fd_count == 0) return false;
-
-        int tmp = rand() % fd_count;
-        int true_num = 0;
-        while (true)
-        {
-            if (_free_digits[true_num])
-            {
-                if (tmp == 0) break;
-                tmp -= 1;
-            }
-            true_num += 1;
-        }
-
-        _digit = true_num + 1;
-        _free_digits[true_num] = false;
-        return true;
-    }
+    _autosave->Reopen(size);
+    return true;
+}
 
-    void SetDigit(int digit)
-    {
-        _digit = digit;
-    }
-};
+bool Sudoku::HasGame() const
+{
+    return _has_game;
+}
 
 void Sudoku::Generate(int open_slots_count)
 {
-    Cell sdk[9][9];
-
-    for (int row = 0; row < 9; )
-    {
-        for (int column = 0; column < 9; )
-        {
-            for (int tmp_column = 0; tmp_column < column; tmp_column += 1)
-            {
-                sdk[row][column].RemoveFD(sdk[row][tmp_column].GetDigit());
-            }
-            for (int tmp_row = 0; tmp_row < row; tmp_row += 1)
-            {
-                sdk[row][column].RemoveFD(sdk[tmp_row][column].GetDigit());
-            }
-
-            {
-                int tmp_row = row / 3 * 3;
-                int tmp_column = column / 3 * 3;
-
-                while (not ((tmp_row == row) && (tmp_column == column)))
-                {
-                    sdk[row][column].RemoveFD(sdk[tmp_row][tmp_column].GetDigit());
-                    tmp_column += 1;
-                    if (tmp_column >= column / 3 * 3 + 3)
-                    {
-                        tmp_row += 1;
-                        tmp_column = column / 3 * 3;
-                    }
-                }
-            }
+    GuiProbe::Scope scope("generate");
+    Engine::Board board;
+    Engine::Generate(board, open_slots_count, Engine::ThreadRng());
 
+    GameState state;
+    state.board = board;
+    state.open_slots_count = open_slots_count;
+    state.sandbox_mode = not open_slots_count;
+    _journal.Start(state);
+    _autosave->Rewrite(_journal.Snapshot());
 
-            if (not sdk[row][column].GenerateDigit())
-            {
-                if ((row == 0) and (column == 0)) exit(-1);
-                sdk[row][column].Reset();
-                if (column == 0)
-                {
-                    row -= 1;
-                    column = 8;
-                }
-                else column -= 1;
-
-                continue;
-            }
-            column += 1;
-        }
-        row += 1;
-    }
-
-    static bool opened[9 * 9];
-    for (int i = 0; i < 9 * 9; i += 1)
-    {
-        opened[i] = false;
-    }
-
-    for (int i = 0; i < open_slots_count; i += 1)
-    {
-        int tmp = rand() % (9 * 9 - i);
-        int true_num = 0;
-        while (true)
-        {
-            if (not opened[true_num])
-            {
-                if (tmp == 0)
-                {
-                    break;
-                }
-                tmp -= 1;
-            }
-            true_num += 1;
-        }
-        opened[true_num] = true;
-    }
     for (int row = 0; row < 9; row += 1)
     {
         for (int column = 0; column < 9; column += 1)
         {
-
-            bool t = true;
-            for (int i = 0; i < open_slots_count; i += 1)
-            {
-                if (opened[column + (row * 9)])
-                {
-                    _cells[row][column]->SetDigit(sdk[row][column].GetDigit());
-                    _cells[row][column]->Lock();
-                    t = false;
-                    break;
-                }
-            }
-            if (t)
-            {
-                _cells[row][column]->SetDigit(0);
-                _cells[row][column]->Open();
-            }
+            _cells[row][column]->SetDigit(board.digits[row][column]);
+            if (board.locked[row][column]) _cells[row][column]->Lock();
+            else _cells[row][column]->Open();
         }
     }
 
     _sandbox_mode = not open_slots_count;
     _open_slots_count = open_slots_count;
+    _seconds = 0;
+    StartGame();
+}
 
+void Sudoku::StartGame()
+{
+    _has_game = true;
     if (_sandbox_mode)
     {
+        _timer->stop();
         _timer_lbl->setText("SANDBOX MODE. Use right-click to open/close cells.");
     }
     else
     {
-        _seconds = 0;
-        _timer_lbl->setText("0 seconds later");
+        _timer_lbl->setText(QString::number(_seconds) + " seconds later");
         _timer->start(1000);
     }
 }
 
+void Sudoku::RecordMove(const Move& move)
+{
+    if (not _has_game) return;
+    _autosave->Append(_journal.Push(move));
+}
+
+void Sudoku::SyncCell(int index)
+{
+    const Engine::Board& board = _journal.Current().board;
+    CellBtn* cell = _cells[index / 9][index % 9];
+    cell->SetDigit(board.digits[index / 9][index % 9]);
+    if (board.locked[index / 9][index % 9]) cell->Lock();
+    else cell->Open();
+}
+
+void Sudoku::Undo()
+{
+    if (not _has_game) return;
+    QVector<int> cells;
+    QByteArray record = _journal.Undo(cells);
+    if (record.isEmpty()) return;
+    for (int cell : cells) SyncCell(cell);
+    _autosave->Append(record);
+}
+
+void Sudoku::Redo()
+{
+    if (not _has_game) return;
+    QVector<int> cells;
+    QByteArray record = _journal.Redo(cells);
+    if (record.isEmpty()) return;
+    for (int cell : cells) SyncCell(cell);
+    _autosave->Append(record);
+}
+
 void Sudoku::Solve()
 {
+    GuiProbe::Scope scope("solve");
     _solve->setText("u dirty cheater /(0\\_/0)\\");
 
-    bool columns [9][9];
-    bool rows [9][9];;
-    bool squares [9][9];
-    for (int i = 0; i < 9; i+=1)
+    Engine::Board board;
+    for (int row = 0; row < 9; row += 1)
     {
-        for (int j = 0; j < 9; j += 1)
+        for (int column = 0; column < 9; column += 1)
         {
-            columns[i][j] = true;
-            rows[i][j] = true;
-            squares[i][j] = true;
+            board.digits[row][column] = _cells[row][column]->GetDigit();
+            board.locked[row][column] = _cells[row][column]->IsLocked();
         }
     }
 
-    for (int column = 0; column < 9; column += 1)
+    if (not _portfolio.Solve(board, _sandbox_mode))
     {
-        for (int row = 0; row < 9; row += 1)
-        {
-            if (not _cells[row][column]->IsLocked())
-            {
-                continue;
-            }
-
-            if (_cells[row][column]->GetDigit() == 0)
-            {
-                _timer_lbl->setText("there are no solutions");
-                _timer_lbl->setStyleSheet("color: red;");
-                return;
-            }
-
-            if ((columns[column][_cells[row][column]->GetDigit()-1]) and (rows[row][_cells[row][column]->GetDigit()-1])
-                    and (squares[row / 3 + column / 3 * 3][_cells[row][column]->GetDigit() - 1]))
-            {
-                columns[column][_cells[row][column]->GetDigit() - 1] = false;
-                rows[row][_cells[row][column]->GetDigit() - 1] = false;
-                squares[row / 3 + column / 3 * 3][_cells[row][column]->GetDigit() - 1] = false;
-            }
-            else
-            {
-                _timer_lbl->setText("there are no solutions");
-                _timer_lbl->setStyleSheet("color: red;");
-                return;
-            }
-        }
-    }
-
-    Cell sdk[9][9];
-
-    for (int row = 0; row < 9; )
-    {
-        for (int column = 0; column < 9; )
-        {
-            if (_cells[row][column]->IsLocked())
-            {
-                sdk[row][column].SetDigit(_cells[row][column]->GetDigit());
-                column += 1;
-                continue;
-            }
-            for (int tmp_column = 0; tmp_column < column; tmp_column += 1)
-            {
-                sdk[row][column].RemoveFD(sdk[row][tmp_column].GetDigit());
-            }
-            for (int tmp_row = 0; tmp_row < row; tmp_row += 1)
-            {
-                sdk[row][column].RemoveFD(sdk[tmp_row][column].GetDigit());
-            }
-            for (int tmp_column = column+1; tmp_column < 9; tmp_column += 1)
-            {
-                if (_cells[row][tmp_column]->IsLocked())
-                {
-                    sdk[row][column].RemoveFD(_cells[row][tmp_column]->GetDigit());
-                }
-            }
-            for (int tmp_row = row+1; tmp_row < 9; tmp_row += 1)
-            {
-                if (_cells[tmp_row][column]->IsLocked())
-                {
-                    sdk[row][column].RemoveFD(_cells[tmp_row][column]->GetDigit());
-                }
-            }
-
-            {
-                int tmp_row = row / 3 * 3;
-                int tmp_column = column / 3 * 3;
-                while (not ((tmp_row == row) and (tmp_column == column)))
-                {
-                    sdk[row][column].RemoveFD(sdk[tmp_row][tmp_column].GetDigit());
-                    tmp_column += 1;
-                    if (tmp_column >= column / 3 * 3 + 3)
-                    {
-                        tmp_row += 1;
-                        tmp_column = column / 3 * 3;
-                    }
-                }
-            }
-
-            {
-                int tmp_row = row / 3 * 3 + 2;
-                int tmp_column = column / 3 * 3 + 2;
-                while (not ((tmp_row == row) and (tmp_column == column)))
-                {
-                    if (_cells[tmp_row][tmp_column]->IsLocked())
-                    {
-                        sdk[row][column].RemoveFD(sdk[tmp_row][tmp_column].GetDigit());
-                    }
-                    tmp_column -= 1;
-                    if (tmp_column < column / 3 * 3)
-                    {
-                        tmp_row -= 1;
-                        tmp_column = column / 3 * 3 + 2;
-                    }
-                }
-            }
-
-            if (not sdk[row][column].GenerateDigit())
-            {
-                sdk[row][column].Reset();
-
-                if (column == 0)
-                {
-                    row -= 1;
-                    column = 9 -1;
-                }
-                else column -= 1;
-
-                if (row<0)
-                {
-                    _timer_lbl->setText("there are no solutions");
-                    _timer_lbl->setStyleSheet("color: red;");
-                    return;
-                }
-
-                while (_cells[row][column]->IsLocked())
-                {
-
-                    if (column == 0)
-                    {
-                        row -= 1;
-                        column = 9 - 1;
-                    }
-                    else column -= 1;
-
-                    if (row<0)
-                    {
-                        _timer_lbl->setText("there are no solutions");
-                        _timer_lbl->setStyleSheet("color: red;");
-                        return;
-                    }
-                }
-
-                continue;
-            }
-            column += 1;
-        }
-        row += 1;
+        _timer_lbl->setText("there are no solutions");
+        _timer_lbl->setStyleSheet("color: red;");
+        return;
     }
 
+    // всё заполнение - один ход: одна отмена возвращает доску целиком
+    bool joined = false;
     for (int row = 0; row < 9; row += 1)
     {
         for (int column = 0; column < 9; column += 1)
         {
-            _cells[row][column]->SetDigit(sdk[row][column].GetDigit());
+            int before = _cells[row][column]->GetDigit();
+            if (before == board.digits[row][column]) continue;
+            _cells[row][column]->SetDigit(board.digits[row][column]);
+            RecordMove({Move::Digit, uint8_t(row * 9 + column), uint8_t(before), uint8_t(board.digits[row][column]), joined});
+            joined = true;
         }
     }
 }
@@ -516,6 +336,9 @@ void Sudoku::Check()
             }
             file.close();
             _sandbox_mode = true;
+            // партия окончена: сохранять и продолжать больше нечего
+            _has_game = false;
+            _autosave->Remove();
         }
     }
     else _check->setStyleSheet("background-color: red;");
@@ -525,6 +348,8 @@ void Sudoku::Update()
 {
     _seconds += 1;
     _timer_lbl->setText(QString::number(_seconds) + " second later");
+    _journal.SetSeconds(_seconds);
+    _autosave->Patch(GameJournal::status_offset, _journal.Status());
     if (_check->styleSheet() == "background-color: red;") _check->setStyleSheet("");
 }
 
@@ -595,9 +420,11 @@ Menu::Menu(QWidget *parent) :
     QWidget(parent),
     _play{new QPushButton("Play!",this)},
     _exit{new QPushButton("Exit",this)},
+    _continue{new QPushButton("Continue",this)},
     _setting{new QLineEdit(this)}
 {
     QGridLayout* main_layout = new QGridLayout(this);
+    main_layout->addWidget(_continue,0,1,1,3);
     main_layout->addWidget(_play,   1,1,1,1);
     main_layout->addWidget(_exit,   1,2,1,1);
     main_layout->addWidget(_setting,1,3,1,1);
@@ -605,9 +432,16 @@ Menu::Menu(QWidget *parent) :
     _setting->setAlignment(Qt::AlignmentFlag::AlignHCenter | Qt::AlignmentFlag::AlignVCenter);
     connect(_play,&QPushButton::clicked,this,&Menu::ClickedPlayBtn);
     connect(_exit,&QPushButton::clicked,this,&Menu::ClickedExitBtn);
+    connect(_continue,&QPushButton::clicked,this,&Menu::Continue);
+    _continue->setEnabled(false);
     this->setLayout(main_layout);
 }
 
+void Menu::SetCanContinue(bool can_continue)
+{
+    _continue->setEnabled(can_continue);
+}
+
 void Menu::ClickedPlayBtn()
 {
     int setting = _setting->text().toInt();
@@ -634,14 +468,19 @@ SdkWindow::SdkWindow() :
     _main_widget->setCurrentWidget(_m);
     connect(_m,&Menu::Play,this,&SdkWindow::gotoSudoku);
     connect(_m,&Menu::Close,this,&SdkWindow::ClickedExitBtn);
+    connect(_m,&Menu::Continue,this,&SdkWindow::continueSudoku);
     connect(_sdk,&Sudoku::ReturnToMenu,this,&SdkWindow::gotoMenu);
     setCentralWidget(_main_widget);
     this->setMinimumSize(400,400);
     this->resize(400,400);
+
+    // последняя партия продолжается сразу при запуске
+    if (_sdk->Resume()) _main_widget->setCurrentWidget(_sdk);
 }
 
 void SdkWindow::gotoMenu()
 {
+    _m->SetCanContinue(_sdk->HasGame());
     _main_widget->setCurrentWidget(_m);
 }
 
@@ -651,6 +490,11 @@ void SdkWindow::gotoSudoku(int setting)
     _main_widget->setCurrentWidget(_sdk);
 }
 
+void SdkWindow::continueSudoku()
+{
+    _main_widget->setCurrentWidget(_sdk);
+}
+
 void SdkWindow::ClickedExitBtn()
 {
     emit Close();
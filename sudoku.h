@@ -14,6 +14,11 @@
 #include <QTimer>
 #include <QLabel>
 #include <QFile>
+#include <QShortcut>
+
+#include "probe.h"
+#include "snapshot.h"
+#include "portfolio.h"
 
 class CellBtn : public QPushButton
 {
@@ -27,6 +32,10 @@ public:
     void Lock();
     void Open();
 
+signals:
+    void DigitChanged(int before, int after);
+    void LockChanged(bool locked);
+
 private slots:
     void ChangeDigit();
 
@@ -46,9 +55,13 @@ public:
     Sudoku(QWidget* parent);
 
     static bool IsSandboxMode();
+    bool Resume();
+    bool HasGame() const;
 public slots:
     void Generate(int open_slots_count);
 private slots:
+    void Undo();
+    void Redo();
     void Solve();
     void Help();
     void ClickedReturnBtn();
@@ -59,6 +72,9 @@ signals:
     void ReturnToMenu();
 private:
     std::pair<int,int> FindError();
+    void StartGame();
+    void RecordMove(const Move& move);
+    void SyncCell(int index);
 
     void resizeEvent(QResizeEvent *event) override;
     void paintEvent(QPaintEvent *) override;
@@ -73,6 +89,14 @@ private:
     uint16_t _seconds;
     QLabel* _timer_lbl;
 
+    GuiProbe* _probe;
+
+    Engine::Portfolio _portfolio;
+
+    GameJournal _journal;
+    Autosave* _autosave;
+    bool _has_game;
+
     static inline bool _sandbox_mode = false;
     int _open_slots_count;
 };
@@ -85,12 +109,16 @@ public:
 private:
     QPushButton* _play;
     QPushButton* _exit;
+    QPushButton* _continue;
     QLineEdit* _setting;
+public slots:
+    void SetCanContinue(bool can_continue);
 private slots:
     void ClickedPlayBtn();
     void ClickedExitBtn();
 signals:
     void Play(int setting);
+    void Continue();
     void Close();
 };
 
@@ -106,6 +134,7 @@ private:
 private slots:
     void gotoMenu();
     void gotoSudoku(int setting);
+    void continueSudoku();
     void ClickedExitBtn();
 signals:
     void Close();
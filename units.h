@@ -0,0 +1,22 @@
+#pragma once
+
+#include "engine.h"
+
+// Общее для решателей engine.cpp и lanes.cpp, в интерфейс Engine не входит
+namespace Engine
+{
+
+// 27 групп по 9 клеток: строки, столбцы, квадраты
+struct Units
+{
+    int cells[27][9];
+
+    Units();
+};
+
+extern const Units units;
+
+// Заблокированные клетки противоречат друг другу или содержат не цифру
+bool HasConflict(const Board& board);
+
+}